@@ -0,0 +1,197 @@
+#include "checker.h"
+#include "stars.h"
+#include "mem.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+struct checker_t {
+	SDL_Thread* thread;
+	SDL_Mutex* lock;
+	SDL_Condition* wake;
+	Uint32 event_type;
+
+	// Bumped by every submit and level change, a running job whose
+	// number no longer matches is stale and stops
+	SDL_AtomicInt generation;
+	SDL_AtomicInt quit;
+
+	// Written by the main thread, guarded by lock
+	int rows;
+	int cols;
+	int stars;
+	int* regions;
+	signed char* givens;
+	int capacity;
+	int level_version;
+	bool pending;
+
+	// Worker thread only
+	level_t* level;
+	int worker_stars;
+	int worker_level_version;
+	signed char* work_givens;
+	int work_capacity;
+};
+
+typedef struct {
+	checker_t* checker;
+	int job;
+} job_t;
+
+static bool
+_is_stale(void* user) {
+	job_t* job = (job_t*)user;
+	return SDL_GetAtomicInt(&job->checker->quit) ||
+		SDL_GetAtomicInt(&job->checker->generation) != job->job;
+}
+
+// Copy the latest board under the lock, reusing worker buffers
+static int
+_take_job(checker_t* checker) {
+	int size = checker->rows * checker->cols;
+
+	if (checker->level_version != checker->worker_level_version) {
+		if (!checker->level || checker->level->rows != checker->rows || checker->level->cols != checker->cols) {
+			if (checker->level) level_destroy(checker->level);
+			checker->level = level_create(checker->rows, checker->cols);
+		}
+		memcpy(checker->level->regions, checker->regions, size * sizeof(int));
+		level_build_regions(checker->level); // once per level, not per check
+		checker->worker_stars = checker->stars;
+		checker->worker_level_version = checker->level_version;
+	}
+
+	if (size > checker->work_capacity) {
+		checker->work_givens = (signed char*)mem_realloc(checker->work_givens, size);
+		assert(checker->work_givens);
+		checker->work_capacity = size;
+	}
+	memcpy(checker->work_givens, checker->givens, size);
+
+	checker->pending = false;
+	return SDL_GetAtomicInt(&checker->generation);
+}
+
+static int
+_worker(void* data) {
+	checker_t* checker = (checker_t*)data;
+
+	for (;;) {
+		SDL_LockMutex(checker->lock);
+		while (!checker->pending && !SDL_GetAtomicInt(&checker->quit)) {
+			SDL_WaitCondition(checker->wake, checker->lock);
+		}
+		if (SDL_GetAtomicInt(&checker->quit)) {
+			SDL_UnlockMutex(checker->lock);
+			break;
+		}
+		job_t job = { checker, _take_job(checker) };
+		SDL_UnlockMutex(checker->lock);
+
+		int found = stars_solve(checker->level, checker->worker_stars, checker->work_givens, 1, NULL, _is_stale, &job);
+		if (found < 0 || _is_stale(&job)) continue;
+
+		SDL_Event event;
+		SDL_zero(event);
+		event.type = checker->event_type;
+		event.user.code = found > 0;
+		event.user.data1 = (void*)(intptr_t)job.job;
+		SDL_PushEvent(&event);
+	}
+
+	return 0;
+}
+
+checker_t*
+checker_create(void) {
+	checker_t* checker = (checker_t*)mem_calloc(1, sizeof(checker_t));
+	assert(checker);
+
+	checker->event_type = SDL_RegisterEvents(1);
+	checker->lock = SDL_CreateMutex();
+	checker->wake = SDL_CreateCondition();
+	if (!checker->event_type || !checker->lock || !checker->wake) {
+		checker_destroy(checker);
+		return NULL;
+	}
+
+	checker->thread = SDL_CreateThread(_worker, "checker", checker);
+	if (!checker->thread) {
+		checker_destroy(checker);
+		return NULL;
+	}
+
+	return checker;
+}
+
+void
+checker_destroy(checker_t* checker) {
+	if (!checker) return;
+
+	if (checker->thread) {
+		SDL_LockMutex(checker->lock);
+		SDL_SetAtomicInt(&checker->quit, 1);
+		SDL_SignalCondition(checker->wake);
+		SDL_UnlockMutex(checker->lock);
+		SDL_WaitThread(checker->thread, NULL);
+	}
+
+	SDL_DestroyCondition(checker->wake);
+	SDL_DestroyMutex(checker->lock);
+
+	if (checker->level) level_destroy(checker->level);
+	mem_free(checker->work_givens);
+	mem_free(checker->givens);
+	mem_free(checker->regions);
+	mem_free(checker);
+}
+
+void
+checker_set_level(checker_t* checker, const level_t* level, int stars) {
+	int size = level->rows * level->cols;
+
+	SDL_LockMutex(checker->lock);
+
+	// Grow here, on level change, so checker_submit never has to
+	if (size > checker->capacity) {
+		checker->regions = (int*)mem_realloc(checker->regions, size * sizeof(int));
+		checker->givens = (signed char*)mem_realloc(checker->givens, size);
+		assert(checker->regions && checker->givens);
+		checker->capacity = size;
+	}
+
+	checker->rows = level->rows;
+	checker->cols = level->cols;
+	checker->stars = stars;
+	memcpy(checker->regions, level->regions, size * sizeof(int));
+	checker->level_version++;
+	checker->pending = false;
+	SDL_AddAtomicInt(&checker->generation, 1);
+
+	SDL_UnlockMutex(checker->lock);
+}
+
+void
+checker_submit(checker_t* checker, const signed char* givens) {
+	SDL_LockMutex(checker->lock);
+
+	memcpy(checker->givens, givens, checker->rows * checker->cols);
+	checker->pending = true;
+	SDL_AddAtomicInt(&checker->generation, 1);
+	SDL_SignalCondition(checker->wake);
+
+	SDL_UnlockMutex(checker->lock);
+}
+
+bool
+checker_result(checker_t* checker, const SDL_Event* event, bool* solvable) {
+	if (event->type != checker->event_type) return false;
+
+	int job = (int)(intptr_t)event->user.data1;
+	if (job != SDL_GetAtomicInt(&checker->generation)) return false;
+
+	*solvable = event->user.code != 0;
+	return true;
+}
@@ -0,0 +1,65 @@
+#ifndef __CHECKER_H
+#define __CHECKER_H
+
+#include "level.h"
+
+#include <SDL3/SDL.h>
+
+/**********************************************************
+ * Background solvability checker
+ *
+ * A worker thread checks whether the player's queens and
+ * marks can still be extended to a solution. Each submit
+ * cancels the job before it, and results come back to the
+ * main loop as an SDL event.
+ **********************************************************/
+
+typedef struct checker_t checker_t;
+
+/**********************************************************
+ * \brief Start the worker thread
+ *
+ * \returns newly created checker, NULL on failure
+ **********************************************************/
+checker_t* checker_create(void);
+
+/**********************************************************
+ * \brief Stop the worker thread and free memory
+ *
+ * \param checker   this
+ **********************************************************/
+void checker_destroy(checker_t* checker);
+
+/**********************************************************
+ * \brief Switch to a new level, cancels any running check
+ *
+ * \param checker   this
+ * \param level     level to check boards against
+ * \param stars     queens per row, column and region
+ **********************************************************/
+void checker_set_level(checker_t* checker, const level_t* level, int stars);
+
+/**********************************************************
+ * \brief Queue a check of the board, replacing older ones
+ *
+ * Only copies the board, so it does not allocate and never
+ * waits for a running check.
+ *
+ * \param checker   this
+ * \param givens    one STARS_GIVEN_* per cell of the level
+ **********************************************************/
+void checker_submit(checker_t* checker, const signed char* givens);
+
+/**********************************************************
+ * \brief Read a result event posted by the worker
+ *
+ * \param checker   this
+ * \param event     event from SDL_AppEvent
+ * \param solvable  receives whether the board can be solved
+ *
+ * \returns false if the event is not a result of the latest
+ *          submitted board
+ **********************************************************/
+bool checker_result(checker_t* checker, const SDL_Event* event, bool* solvable);
+
+#endif /* __CHECKER_H */
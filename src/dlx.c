@@ -0,0 +1,388 @@
+#include "dlx.h"
+#include "mem.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct dlx_t {
+	int items;
+	int primary;
+
+	// Active primary items, root is node `items`
+	int* llink;
+	int* rlink;
+
+	// Per item: remaining quota and number of live options
+	int* need;
+	int* len;
+
+	// Nodes 0..items-1 are column headers, option nodes follow
+	int* top;
+	int* opt;
+	int* ulink;
+	int* dlink;
+	int node_count;
+	int node_cap;
+
+	int* option_start;
+	int* option_size;
+	int option_count;
+	int option_cap;
+
+	int* chosen;
+	int chosen_count;
+	int* excluded;
+	int excluded_count;
+
+	int* solution;
+	int solution_size;
+	int found;
+	int limit;
+
+	long long nodes;
+	bool stopped;
+	dlx_stop_fn stop;
+	void* user;
+};
+
+dlx_t*
+dlx_create(int items, int primary, int max_options, int max_nodes) {
+	assert(items > 0 && primary >= 0 && primary <= items);
+
+	dlx_t* dlx = (dlx_t*)mem_calloc(1, sizeof(dlx_t));
+	assert(dlx);
+
+	dlx->items = items;
+	dlx->primary = primary;
+	dlx->node_cap = items + max_nodes;
+	dlx->option_cap = max_options;
+
+	dlx->llink = (int*)mem_malloc((items + 1) * sizeof(int));
+	dlx->rlink = (int*)mem_malloc((items + 1) * sizeof(int));
+	dlx->need = (int*)mem_malloc(items * sizeof(int));
+	dlx->len = (int*)mem_malloc(items * sizeof(int));
+	dlx->top = (int*)mem_malloc(dlx->node_cap * sizeof(int));
+	dlx->opt = (int*)mem_malloc(dlx->node_cap * sizeof(int));
+	dlx->ulink = (int*)mem_malloc(dlx->node_cap * sizeof(int));
+	dlx->dlink = (int*)mem_malloc(dlx->node_cap * sizeof(int));
+	dlx->option_start = (int*)mem_malloc((max_options + 1) * sizeof(int));
+	dlx->option_size = (int*)mem_malloc((max_options + 1) * sizeof(int));
+	dlx->chosen = (int*)mem_malloc((max_options + 1) * sizeof(int));
+	dlx->excluded = (int*)mem_malloc((max_options + 1) * sizeof(int));
+	dlx->solution = (int*)mem_malloc((max_options + 1) * sizeof(int));
+	assert(dlx->llink && dlx->rlink && dlx->need && dlx->len);
+	assert(dlx->top && dlx->opt && dlx->ulink && dlx->dlink);
+	assert(dlx->option_start && dlx->option_size);
+	assert(dlx->chosen && dlx->excluded && dlx->solution);
+
+	// Link primary items into the active list
+	int root = items;
+	int prev = root;
+	for (int i = 0; i < primary; ++i) {
+		dlx->llink[i] = prev;
+		dlx->rlink[prev] = i;
+		prev = i;
+	}
+	dlx->rlink[prev] = root;
+	dlx->llink[root] = prev;
+	for (int i = primary; i < items; ++i) {
+		dlx->llink[i] = i;
+		dlx->rlink[i] = i;
+	}
+
+	for (int i = 0; i < items; ++i) {
+		dlx->need[i] = 1;
+		dlx->len[i] = 0;
+		dlx->top[i] = i;
+		dlx->opt[i] = -1;
+		dlx->ulink[i] = i;
+		dlx->dlink[i] = i;
+	}
+	dlx->node_count = items;
+
+	return dlx;
+}
+
+void
+dlx_destroy(dlx_t* dlx) {
+	if (!dlx) return;
+
+	mem_free(dlx->llink);
+	mem_free(dlx->rlink);
+	mem_free(dlx->need);
+	mem_free(dlx->len);
+	mem_free(dlx->top);
+	mem_free(dlx->opt);
+	mem_free(dlx->ulink);
+	mem_free(dlx->dlink);
+	mem_free(dlx->option_start);
+	mem_free(dlx->option_size);
+	mem_free(dlx->chosen);
+	mem_free(dlx->excluded);
+	mem_free(dlx->solution);
+	mem_free(dlx);
+}
+
+void
+dlx_set_quota(dlx_t* dlx, int item, int quota) {
+	assert(item >= 0 && item < dlx->items);
+	assert(quota >= 1);
+	dlx->need[item] = quota;
+}
+
+int
+dlx_add_option(dlx_t* dlx, const int* items, int count) {
+	assert(count > 0);
+	assert(dlx->option_count < dlx->option_cap);
+	assert(dlx->node_count + count <= dlx->node_cap);
+
+	int o = dlx->option_count++;
+	dlx->option_start[o] = dlx->node_count;
+	dlx->option_size[o] = count;
+
+	for (int k = 0; k < count; ++k) {
+		int item = items[k];
+		assert(item >= 0 && item < dlx->items);
+
+		// Append to the bottom of the item's column
+		int x = dlx->node_count++;
+		dlx->top[x] = item;
+		dlx->opt[x] = o;
+		dlx->ulink[x] = dlx->ulink[item];
+		dlx->dlink[x] = item;
+		dlx->dlink[dlx->ulink[item]] = x;
+		dlx->ulink[item] = x;
+		dlx->len[item]++;
+	}
+
+	return o;
+}
+
+static inline void
+_unlink_node(dlx_t* dlx, int x) {
+	int u = dlx->ulink[x];
+	int d = dlx->dlink[x];
+	dlx->dlink[u] = d;
+	dlx->ulink[d] = u;
+	dlx->len[dlx->top[x]]--;
+}
+
+static inline void
+_relink_node(dlx_t* dlx, int x) {
+	dlx->dlink[dlx->ulink[x]] = x;
+	dlx->ulink[dlx->dlink[x]] = x;
+	dlx->len[dlx->top[x]]++;
+}
+
+// Remove every node of an option from its column
+static void
+_hide_option(dlx_t* dlx, int o) {
+	int start = dlx->option_start[o];
+	int end = start + dlx->option_size[o];
+	for (int x = start; x < end; ++x) {
+		_unlink_node(dlx, x);
+	}
+}
+
+static void
+_unhide_option(dlx_t* dlx, int o) {
+	int start = dlx->option_start[o];
+	for (int x = start + dlx->option_size[o] - 1; x >= start; --x) {
+		_relink_node(dlx, x);
+	}
+}
+
+// Remove the option containing p from every column except p's
+static void
+_hide_others(dlx_t* dlx, int p) {
+	int o = dlx->opt[p];
+	int start = dlx->option_start[o];
+	int end = start + dlx->option_size[o];
+	for (int x = start; x < end; ++x) {
+		if (x != p) _unlink_node(dlx, x);
+	}
+}
+
+static void
+_unhide_others(dlx_t* dlx, int p) {
+	int o = dlx->opt[p];
+	int start = dlx->option_start[o];
+	for (int x = start + dlx->option_size[o] - 1; x >= start; --x) {
+		if (x != p) _relink_node(dlx, x);
+	}
+}
+
+// Item quota is exhausted: retire it and everything that still uses it
+static void
+_cover(dlx_t* dlx, int item) {
+	if (item < dlx->primary) {
+		dlx->rlink[dlx->llink[item]] = dlx->rlink[item];
+		dlx->llink[dlx->rlink[item]] = dlx->llink[item];
+	}
+	for (int p = dlx->dlink[item]; p != item; p = dlx->dlink[p]) {
+		_hide_others(dlx, p);
+	}
+}
+
+static void
+_uncover(dlx_t* dlx, int item) {
+	for (int p = dlx->ulink[item]; p != item; p = dlx->ulink[p]) {
+		_unhide_others(dlx, p);
+	}
+	if (item < dlx->primary) {
+		dlx->rlink[dlx->llink[item]] = item;
+		dlx->llink[dlx->rlink[item]] = item;
+	}
+}
+
+static void
+_use(dlx_t* dlx, int o) {
+	_hide_option(dlx, o);
+
+	int start = dlx->option_start[o];
+	int end = start + dlx->option_size[o];
+	for (int x = start; x < end; ++x) {
+		int item = dlx->top[x];
+		if (--dlx->need[item] == 0) {
+			_cover(dlx, item);
+		}
+	}
+	dlx->chosen[dlx->chosen_count++] = o;
+}
+
+static void
+_unuse(dlx_t* dlx, int o) {
+	dlx->chosen_count--;
+
+	int start = dlx->option_start[o];
+	for (int x = start + dlx->option_size[o] - 1; x >= start; --x) {
+		int item = dlx->top[x];
+		if (dlx->need[item] == 0) {
+			_uncover(dlx, item);
+		}
+		dlx->need[item]++;
+	}
+
+	_unhide_option(dlx, o);
+}
+
+static bool
+_available(const dlx_t* dlx, int o) {
+	int start = dlx->option_start[o];
+	int end = start + dlx->option_size[o];
+	for (int x = start; x < end; ++x) {
+		if (dlx->dlink[dlx->ulink[x]] != x) return false;
+		if (dlx->need[dlx->top[x]] <= 0) return false;
+	}
+	return true;
+}
+
+bool
+dlx_select(dlx_t* dlx, int option) {
+	assert(option >= 0 && option < dlx->option_count);
+
+	if (!_available(dlx, option)) return false;
+	_use(dlx, option);
+	return true;
+}
+
+void
+dlx_exclude(dlx_t* dlx, int option) {
+	assert(option >= 0 && option < dlx->option_count);
+
+	if (!_available(dlx, option)) return;
+	_hide_option(dlx, option);
+}
+
+void
+dlx_set_stop(dlx_t* dlx, dlx_stop_fn stop, void* user) {
+	dlx->stop = stop;
+	dlx->user = user;
+}
+
+static void
+_search(dlx_t* dlx) {
+	dlx->nodes++;
+	if (dlx->stop && (dlx->nodes & 1023) == 0 && dlx->stop(dlx->user)) {
+		dlx->stopped = true;
+		return;
+	}
+
+	int root = dlx->items;
+	if (dlx->rlink[root] == root) {
+		if (dlx->found == 0) {
+			memcpy(dlx->solution, dlx->chosen, dlx->chosen_count * sizeof(int));
+			dlx->solution_size = dlx->chosen_count;
+		}
+		dlx->found++;
+		return;
+	}
+
+	// Branch on the item with the least slack between live options and need
+	int best = -1;
+	int best_slack = 0;
+	for (int i = dlx->rlink[root]; i != root; i = dlx->rlink[i]) {
+		int slack = dlx->len[i] - dlx->need[i];
+		if (best == -1 || slack < best_slack ||
+			(slack == best_slack && dlx->len[i] < dlx->len[best])) {
+			best = i;
+			best_slack = slack;
+			if (slack < 0) return;
+		}
+	}
+
+	int mark = dlx->excluded_count;
+
+	for (int p = dlx->dlink[best]; p != best; ) {
+		int o = dlx->opt[p];
+		int next = dlx->dlink[p];
+
+		_use(dlx, o);
+		_search(dlx);
+		_unuse(dlx, o);
+
+		if (dlx->stopped || dlx->found >= dlx->limit) break;
+
+		// Remaining branches are the solutions without this option
+		_hide_option(dlx, o);
+		dlx->excluded[dlx->excluded_count++] = o;
+		if (dlx->len[best] < dlx->need[best]) break;
+
+		p = next;
+	}
+
+	while (dlx->excluded_count > mark) {
+		_unhide_option(dlx, dlx->excluded[--dlx->excluded_count]);
+	}
+}
+
+int
+dlx_solve(dlx_t* dlx, int limit, int* solution, int* size) {
+	assert(limit > 0);
+
+	dlx->found = 0;
+	dlx->limit = limit;
+	dlx->nodes = 0;
+	dlx->stopped = false;
+	dlx->solution_size = 0;
+
+	_search(dlx);
+
+	if (dlx->found > 0) {
+		if (solution) {
+			memcpy(solution, dlx->solution, dlx->solution_size * sizeof(int));
+		}
+		if (size) *size = dlx->solution_size;
+	}
+	else if (size) {
+		*size = 0;
+	}
+
+	return dlx->stopped ? -1 : dlx->found;
+}
+
+long long
+dlx_nodes(const dlx_t* dlx) {
+	return dlx->nodes;
+}
@@ -0,0 +1,108 @@
+#ifndef __DLX_H
+#define __DLX_H
+
+#include <stdbool.h>
+
+/**********************************************************
+ * Exact cover with item quotas (dancing links)
+ *
+ * Items 0..primary-1 must be covered exactly `quota` times,
+ * items primary..items-1 are secondary and may be covered at
+ * most `quota` times. Links are stored in flat int arrays
+ * indexed by node rather than as pointer nodes.
+ **********************************************************/
+
+typedef struct dlx_t dlx_t;
+
+typedef bool (*dlx_stop_fn)(void* user);
+
+/**********************************************************
+ * \brief Create a solver
+ *
+ * \param items       total number of items
+ * \param primary     number of primary items (first `primary` ids)
+ * \param max_options maximum number of options that will be added
+ * \param max_nodes   maximum total items over all options
+ *
+ * \returns newly created solver, every quota set to 1
+ **********************************************************/
+dlx_t* dlx_create(int items, int primary, int max_options, int max_nodes);
+
+/**********************************************************
+ * \brief Free solver memory
+ *
+ * \param dlx       this
+ **********************************************************/
+void dlx_destroy(dlx_t* dlx);
+
+/**********************************************************
+ * \brief Set how many times an item must (primary) or may
+ *        (secondary) be covered
+ *
+ * \param dlx       this
+ * \param item      item id
+ * \param quota     quota, must be >= 1
+ **********************************************************/
+void dlx_set_quota(dlx_t* dlx, int item, int quota);
+
+/**********************************************************
+ * \brief Add an option covering the given items
+ *
+ * \param dlx       this
+ * \param items     item ids, each at most once
+ * \param count     number of item ids
+ *
+ * \returns option id
+ **********************************************************/
+int dlx_add_option(dlx_t* dlx, const int* items, int count);
+
+/**********************************************************
+ * \brief Force an option into every solution
+ *
+ * \param dlx       this
+ * \param option    option id
+ *
+ * \returns false if the option conflicts with earlier choices
+ **********************************************************/
+bool dlx_select(dlx_t* dlx, int option);
+
+/**********************************************************
+ * \brief Forbid an option from every solution
+ *
+ * \param dlx       this
+ * \param option    option id
+ **********************************************************/
+void dlx_exclude(dlx_t* dlx, int option);
+
+/**********************************************************
+ * \brief Set a callback polled during search to abort it
+ *
+ * \param dlx       this
+ * \param stop      callback, NULL to disable
+ * \param user      passed to callback
+ **********************************************************/
+void dlx_set_stop(dlx_t* dlx, dlx_stop_fn stop, void* user);
+
+/**********************************************************
+ * \brief Search for solutions
+ *
+ * \param dlx       this
+ * \param limit     stop after this many solutions
+ * \param solution  optional, receives option ids of the first
+ *                  solution (including selected options)
+ * \param size      optional, receives number of ids written
+ *
+ * \returns number of solutions found up to limit, -1 if stopped
+ **********************************************************/
+int dlx_solve(dlx_t* dlx, int limit, int* solution, int* size);
+
+/**********************************************************
+ * \brief Number of search nodes visited by the last solve
+ *
+ * \param dlx       this
+ *
+ * \returns node count
+ **********************************************************/
+long long dlx_nodes(const dlx_t* dlx);
+
+#endif /* __DLX_H */
@@ -1,10 +1,13 @@
 #include "grid.h"
 
-#include "vector.h"
-#include "intset.h"
+#include "mem.h"
+#include "stars.h"
+#include "vector2.h"
 
-#include <malloc.h>
 #include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 #include <SDL3_image/SDL_image.h>
@@ -27,14 +30,30 @@ typedef struct {
 
 typedef enum { DRAG_NONE, DRAG_PAINT_PLUS, DRAG_ERASE_PLUS } drag_mode_t;
 
+// Motion samples buffered between two stroke flushes
+#define GRID_STROKE_MAX 64
+
+// Gap left around each cell, as a fraction of the cell size
+#define GRID_CELL_GAP 0.0125f
+
 struct grid_t {
 	int rows;
 	int cols;
+	int stars; // queens per row, column and region
 	float cell_size;
-	vector_t* cells; // cell_t
+	level_t* level; // own copy, with region lists and borders
+	cell_t* cells;
+	int cell_cap;
+	int* region_queens; // scratch for grid_check_win, one per region id
+	int region_cap;
+	int region_count;
+	signed char* givens; // snapshot for the solvability checker
+	bool solvable;
 	bool left_mouse_down;
-	int last_r, last_c;
+	int last_r, last_c; // last stroke cell, may lie outside the grid
 	drag_mode_t drag_mode;
+	vector2i stroke[GRID_STROKE_MAX]; // pending motion cells, {row, col}
+	int stroke_len;
 	SDL_Texture* crown;
 };
 
@@ -52,32 +71,36 @@ _region_colour(int id, color_t* out_color) {
 static
 bool
 _can_place_queen(const grid_t* grid, int row, int col) {
-	cell_t* t = (cell_t*)vector_get(grid->cells, row * grid->cols + col);
-
-	// Only one queen per region
-	V_FOREACH(grid->cells, cell_t, cell, cell_index) {
-		if (cell->state == CELL_QUEEN && cell->region == t->region) {
-			return false;
+	const level_t* level = grid->level;
+	int region = grid->cells[row * grid->cols + col].region;
+
+	// At most `stars` queens per region, column and row
+	int in_region = 0;
+	for (int k = level->region_start[region]; k < level->region_start[region + 1]; ++k) {
+		if (grid->cells[level->region_cells[k]].state == CELL_QUEEN) {
+			in_region++;
 		}
 	}
 
-	// Only one queen per row
+	int in_col = 0;
 	for (int i = 0; i < grid->rows; ++i) {
-		cell_t* cell = (cell_t*)vector_get(grid->cells, i * grid->cols + col);
-		if (cell->state == CELL_QUEEN) {
-			return false;
+		if (grid->cells[i * grid->cols + col].state == CELL_QUEEN) {
+			in_col++;
 		}
 	}
 
-	// Only one queen per column
+	int in_row = 0;
 	for (int i = 0; i < grid->cols; ++i) {
-		cell_t* cell = (cell_t*)vector_get(grid->cells, row * grid->cols + i);
-		if (cell->state == CELL_QUEEN) {
-			return false;
+		if (grid->cells[row * grid->cols + i].state == CELL_QUEEN) {
+			in_row++;
 		}
 	}
 
-	// Only one queen adjacent (including diagonals)
+	if (in_region >= grid->stars || in_col >= grid->stars || in_row >= grid->stars) {
+		return false;
+	}
+
+	// No queen adjacent (including diagonals)
 	for (int dr = -1; dr <= 1; ++dr) {
 		for (int dc = -1; dc <= 1; ++dc) {
 			if (dr == 0 && dc == 0) {
@@ -86,7 +109,7 @@ _can_place_queen(const grid_t* grid, int row, int col) {
 			int nr = row + dr;
 			int nc = col + dc;
 			if (nr >= 0 && nc >= 0 && nr < grid->rows && nc < grid->cols) {
-				cell_t* cell = (cell_t*)vector_get(grid->cells, nr * grid->cols + nc);
+				cell_t* cell = &grid->cells[nr * grid->cols + nc];
 				if (cell->state == CELL_QUEEN) {
 					return false;
 				}
@@ -98,12 +121,17 @@ _can_place_queen(const grid_t* grid, int row, int col) {
 }
 
 grid_t* 
-grid_create(SDL_Renderer *renderer, const level_t const* level, float cell_size) {
-	grid_t* grid = (grid_t*)malloc(sizeof(grid_t));
+grid_create(SDL_Renderer *renderer, const level_t const* level, int stars, float cell_size) {
+	grid_t* grid = (grid_t*)mem_malloc(sizeof(grid_t));
 	assert(grid);
+	grid->level = NULL;
 	grid->cells = NULL;
+	grid->cell_cap = 0;
+	grid->region_queens = NULL;
+	grid->region_cap = 0;
+	grid->givens = NULL;
 
-	grid_reset(grid, level, cell_size);
+	grid_reset(grid, level, stars, cell_size);
 
 	grid->crown = IMG_LoadTexture(renderer, "assets/crown.png");
 	if (!grid->crown) {
@@ -115,41 +143,55 @@ grid_create(SDL_Renderer *renderer, const level_t const* level, float cell_size)
 }
 
 void
-grid_reset(grid_t* grid, const level_t const* level, float cell_size) {
+grid_reset(grid_t* grid, const level_t const* level, int stars, float cell_size) {
 	grid->rows = level->rows;
 	grid->cols = level->cols;
+	grid->stars = stars;
 	grid->cell_size = cell_size;
 
 	grid->left_mouse_down = false;
 	grid->drag_mode = DRAG_NONE;
 	grid->last_r = -1;
 	grid->last_c = -1;
+	grid->stroke_len = 0;
 
-	if (grid->cells != NULL) {
-		V_FOREACH(grid->cells, cell_t, cell, c_i) {
-			free(cell);
-		}
-		vector_destroy(grid->cells);
+	if (grid->level) {
+		level_destroy(grid->level);
 	}
+	grid->level = level_clone(level);
 
-	grid->cells = vector_new(); // cell_t
-
+	// Storage is reused across levels and only grows
 	int size = grid->rows * grid->cols;
+	if (size > grid->cell_cap) {
+		grid->cells = (cell_t*)mem_realloc(grid->cells, size * sizeof(cell_t));
+		grid->givens = (signed char*)mem_realloc(grid->givens, size);
+		assert(grid->cells && grid->givens);
+		grid->cell_cap = size;
+	}
+	grid->solvable = true;
+
 	for (int i = 0; i < size; ++i) {
-		cell_t* cell = (cell_t*)malloc(sizeof(cell_t));
-		assert(cell);
+		cell_t* cell = &grid->cells[i];
 		cell->region = level->regions[i];
-		_region_colour(cell->region, &cell->color);
+		_region_colour(grid->level->colours[cell->region], &cell->color);
 		cell->state = CELL_EMPTY;
-		vector_add(grid->cells, cell);
+	}
+
+	grid->region_count = grid->level->region_count;
+	if (grid->region_count > grid->region_cap) {
+		grid->region_queens = (int*)mem_realloc(grid->region_queens, grid->region_count * sizeof(int));
+		assert(grid->region_queens);
+		grid->region_cap = grid->region_count;
 	}
 }
 
-static void
+// Returns true if the cell changed state
+static bool
 _apply_left_drag(grid_t* grid, int r, int c) {
-	cell_t* cell = (cell_t*)vector_get(grid->cells, r * grid->cols + c);
+	cell_t* cell = &grid->cells[r * grid->cols + c];
+	cell_state_t before = cell->state;
 
-	if (cell->state == CELL_QUEEN) return;
+	if (before == CELL_QUEEN) return false;
 
 	if (grid->drag_mode == DRAG_PAINT_PLUS) {
 		cell->state = CELL_PLUS;
@@ -157,10 +199,67 @@ _apply_left_drag(grid_t* grid, int r, int c) {
 	else if (grid->drag_mode == DRAG_ERASE_PLUS) {
 		if (cell->state == CELL_PLUS) cell->state = CELL_EMPTY;
 	}
+	return cell->state != before;
 }
 
-void
+// Visit every cell on the line from (r0, c0) to (r1, c1), start excluded.
+// Returns true if any cell changed state
+static bool
+_apply_left_drag_line(grid_t* grid, int r0, int c0, int r1, int c1) {
+	bool changed = false;
+	int dr = abs(r1 - r0);
+	int dc = abs(c1 - c0);
+	int sr = r0 < r1 ? 1 : -1;
+	int sc = c0 < c1 ? 1 : -1;
+	int err = dc - dr;
+
+	int r = r0;
+	int c = c0;
+	while (r != r1 || c != c1) {
+		int e2 = 2 * err;
+		if (e2 > -dr) {
+			err -= dr;
+			c += sc;
+		}
+		if (e2 < dc) {
+			err += dc;
+			r += sr;
+		}
+
+		if (r >= 0 && r < grid->rows && c >= 0 && c < grid->cols) {
+			changed |= _apply_left_drag(grid, r, c);
+		}
+	}
+	return changed;
+}
+
+static bool
+_flush_stroke(grid_t* grid) {
+	bool changed = false;
+	for (int i = 0; i < grid->stroke_len; ++i) {
+		vector2i p = grid->stroke[i];
+		changed |= _apply_left_drag_line(grid, grid->last_r, grid->last_c, p.x, p.y);
+		grid->last_r = p.x;
+		grid->last_c = p.y;
+	}
+	grid->stroke_len = 0;
+	return changed;
+}
+
+bool
+grid_update(grid_t* grid) {
+	return _flush_stroke(grid);
+}
+
+bool
 grid_handle_event(grid_t* grid, SDL_Event* event) {
+	bool changed = false;
+
+	// Anything but motion must see the stroke applied so far
+	if (event->type != SDL_EVENT_MOUSE_MOTION) {
+		changed = _flush_stroke(grid);
+	}
+
 	switch (event->type) {
 
 		case SDL_EVENT_MOUSE_BUTTON_DOWN: {
@@ -173,7 +272,7 @@ grid_handle_event(grid_t* grid, SDL_Event* event) {
 				grid->left_mouse_down = true;
 
 				// Determine drag intent based on what we clicked
-				cell_t* cell = (cell_t*)vector_get(grid->cells, r * grid->cols + c);
+				cell_t* cell = &grid->cells[r * grid->cols + c];
 				if (cell->state == CELL_QUEEN) break;
 
 				// Single-click toggle still works:
@@ -182,6 +281,7 @@ grid_handle_event(grid_t* grid, SDL_Event* event) {
 
 				// Drag mode follows what the click just did
 				grid->drag_mode = was_plus ? DRAG_ERASE_PLUS : DRAG_PAINT_PLUS;
+				changed = true;
 
 				// IMPORTANT: prevent the first motion from re-processing same cell
 				grid->last_r = r;
@@ -190,13 +290,15 @@ grid_handle_event(grid_t* grid, SDL_Event* event) {
 			}
 
 			if (event->button.button == SDL_BUTTON_RIGHT) {
-				cell_t* cell = (cell_t*)vector_get(grid->cells, r * grid->cols + c);
+				cell_t* cell = &grid->cells[r * grid->cols + c];
 				if (cell->state == CELL_QUEEN) {
 					cell->state = CELL_EMPTY;
+					changed = true;
 				}
 				else {
 					if (_can_place_queen(grid, r, c)) {
 						cell->state = CELL_QUEEN;
+						changed = true;
 					}
 				}
 				break;
@@ -212,19 +314,21 @@ grid_handle_event(grid_t* grid, SDL_Event* event) {
 			break;
 
 		case SDL_EVENT_MOUSE_MOTION: {
-			if (!grid->left_mouse_down) break;
+			if (!grid->left_mouse_down || grid->drag_mode == DRAG_NONE) break;
 
-			int c = event->motion.x / grid->cell_size;
-			int r = event->motion.y / grid->cell_size;
+			// Samples outside the grid are kept so the line back in is right
+			int c = (int)floorf(event->motion.x / grid->cell_size);
+			int r = (int)floorf(event->motion.y / grid->cell_size);
 
-			if (r < 0 || r >= grid->rows || c < 0 || c >= grid->cols) break;
-
-			if (r == grid->last_r && c == grid->last_c) break;
-
-			grid->last_r = r;
-			grid->last_c = c;
+			vector2i last = grid->stroke_len > 0
+				? grid->stroke[grid->stroke_len - 1]
+				: (vector2i){ grid->last_r, grid->last_c };
+			if (r == last.x && c == last.y) break;
 
-			_apply_left_drag(grid, r, c);
+			if (grid->stroke_len == GRID_STROKE_MAX) {
+				changed = _flush_stroke(grid);
+			}
+			grid->stroke[grid->stroke_len++] = (vector2i){ r, c };
 			break;
 		}
 
@@ -233,45 +337,91 @@ grid_handle_event(grid_t* grid, SDL_Event* event) {
 			grid->drag_mode = DRAG_NONE;
 			break;
 	}
+
+	return changed;
 }
 
 bool
 grid_check_win(const grid_t const* grid) {
-	intset_t regions;
-	intset_t regions_with_queen;
-	int cell_count = (int)vector_size(grid->cells);
-
-	if (!intset_init(&regions, cell_count)) return false;
-	if (!intset_init(&regions_with_queen, cell_count)) {
-		intset_destroy(&regions);
-		return false;
-	}
-
+	// Runs every frame, so it must not allocate
+	int size = grid->rows * grid->cols;
 	int queen_count = 0;
 
-	V_FOREACH(grid->cells, cell_t, cell, cell_index) {
-		intset_insert(&regions, cell->region);
+	memset(grid->region_queens, 0, grid->region_cap * sizeof(int));
+
+	for (int i = 0; i < size; ++i) {
+		const cell_t* cell = &grid->cells[i];
 		if (cell->state == CELL_QUEEN) {
 			queen_count++;
-			intset_insert(&regions_with_queen, cell->region);
+			grid->region_queens[cell->region]++;
+		}
+	}
+
+	// Placement caps rows and columns at `stars`, so with every region
+	// full they hold exactly that many too
+	for (int g = 0; g < grid->region_count; ++g) {
+		if (grid->region_queens[g] != grid->stars) {
+			return false;
+		}
+	}
+
+	return queen_count > 0 && queen_count == grid->region_count * grid->stars;
+}
+
+const signed char*
+grid_snapshot(grid_t* grid) {
+	int size = grid->rows * grid->cols;
+	for (int i = 0; i < size; ++i) {
+		switch (grid->cells[i].state) {
+			case CELL_QUEEN: grid->givens[i] = STARS_GIVEN_QUEEN; break;
+			case CELL_PLUS: grid->givens[i] = STARS_GIVEN_EMPTY; break;
+			default: grid->givens[i] = STARS_GIVEN_NONE; break;
+		}
+	}
+	return grid->givens;
+}
+
+void
+grid_restore(grid_t* grid, const signed char* givens) {
+	int size = grid->rows * grid->cols;
+	for (int i = 0; i < size; ++i) {
+		switch (givens[i]) {
+			case STARS_GIVEN_QUEEN: grid->cells[i].state = CELL_QUEEN; break;
+			case STARS_GIVEN_EMPTY: grid->cells[i].state = CELL_PLUS; break;
+			default: grid->cells[i].state = CELL_EMPTY; break;
 		}
 	}
+}
 
-	bool won = (queen_count > 0) &&
-		(queen_count == regions.size) &&
-		(queen_count == regions_with_queen.size);
+void
+grid_set_solvable(grid_t* grid, bool solvable) {
+	grid->solvable = solvable;
+}
 
-	intset_destroy(&regions_with_queen);
-	intset_destroy(&regions);
-	return won;
+// Thick lines along the cached region borders
+static void
+_draw_borders(SDL_Renderer* renderer, const level_t* level, float x, float y, float cell_w, float cell_h) {
+	float t = (cell_w < cell_h ? cell_w : cell_h) * 0.06f;
+	if (t < 1.f) t = 1.f;
+
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+	for (int i = 0; i < level->border_count; ++i) {
+		const level_edge_t* e = &level->borders[i];
+		SDL_FRect rect = { x + e->x0 * cell_w - t / 2, y + e->y0 * cell_h - t / 2,
+						   (e->x1 - e->x0) * cell_w + t, (e->y1 - e->y0) * cell_h + t };
+		SDL_RenderFillRect(renderer, &rect);
+	}
 }
 
 void
 grid_draw(const grid_t* grid, SDL_Renderer* renderer) {
+	float gap = grid->cell_size * GRID_CELL_GAP;
+
 	for (int r = 0; r < grid->rows; ++r) {
 		for (int c = 0; c < grid->cols; ++c) {
-			cell_t* cell = (cell_t*)vector_get(grid->cells, r * grid->cols + c);
-			SDL_FRect rect = { c * grid->cell_size + 1, r * grid->cell_size + 1, grid->cell_size - 2.f, grid->cell_size - 2.f };
+			cell_t* cell = &grid->cells[r * grid->cols + c];
+			SDL_FRect rect = { c * grid->cell_size + gap, r * grid->cell_size + gap,
+							   grid->cell_size - 2.f * gap, grid->cell_size - 2.f * gap };
 			SDL_SetRenderDrawColor(renderer, cell->color.r, cell->color.g, cell->color.b, 255);
 			SDL_RenderFillRect(renderer, &rect);
 
@@ -298,4 +448,40 @@ grid_draw(const grid_t* grid, SDL_Renderer* renderer) {
 			}
 		}
 	}
-}
\ No newline at end of file
+
+	_draw_borders(renderer, grid->level, 0.f, 0.f, grid->cell_size, grid->cell_size);
+
+	// Red frame once the marks rule out every solution
+	if (!grid->solvable) {
+		float t = grid->cell_size * 0.08f;
+		float w = grid->cols * grid->cell_size;
+		float h = grid->rows * grid->cell_size;
+		SDL_FRect frame[4] = {
+			{ 0.f, 0.f, w, t }, { 0.f, h - t, w, t },
+			{ 0.f, 0.f, t, h }, { w - t, 0.f, t, h }
+		};
+		SDL_SetRenderDrawColor(renderer, 230, 30, 30, 255);
+		SDL_RenderFillRects(renderer, frame, 4);
+	}
+}
+void
+grid_draw_level(SDL_Renderer* renderer, const level_t* level, const SDL_FRect* dst) {
+	float cell_w = dst->w / level->cols;
+	float cell_h = dst->h / level->rows;
+	float gap_w = cell_w * GRID_CELL_GAP;
+	float gap_h = cell_h * GRID_CELL_GAP;
+
+	for (int r = 0; r < level->rows; ++r) {
+		for (int c = 0; c < level->cols; ++c) {
+			color_t color;
+			_region_colour(level->colours[level->regions[r * level->cols + c]], &color);
+
+			SDL_FRect rect = { dst->x + c * cell_w + gap_w, dst->y + r * cell_h + gap_h,
+							   cell_w - 2.f * gap_w, cell_h - 2.f * gap_h };
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
+			SDL_RenderFillRect(renderer, &rect);
+		}
+	}
+
+	_draw_borders(renderer, level, dst->x, dst->y, cell_w, cell_h);
+}
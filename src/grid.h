@@ -7,14 +7,33 @@
 
 typedef struct grid_t grid_t;
 
-grid_t* grid_create(SDL_Renderer* renderer, const level_t const *level, float cell_size);
+// stars is the number of queens each row, column and region takes
+grid_t* grid_create(SDL_Renderer* renderer, const level_t const *level, int stars, float cell_size);
 
-void grid_reset(grid_t* grid, const level_t const* level, float cell_size);
+void grid_reset(grid_t* grid, const level_t const* level, int stars, float cell_size);
 
-void grid_handle_event(grid_t* grid, SDL_Event* event);
+// Returns true if the board changed and needs to be redrawn
+bool grid_handle_event(grid_t* grid, SDL_Event* event);
+
+// Apply input buffered by grid_handle_event, call once per frame.
+// Returns true if the board changed and needs to be redrawn
+bool grid_update(grid_t* grid);
 
 bool grid_check_win(const grid_t const* grid);
 
+// Queens and marks as STARS_GIVEN_* per cell, valid until the next call
+const signed char* grid_snapshot(grid_t* grid);
+
+// Put back queens and marks taken with grid_snapshot, one per cell
+void grid_restore(grid_t* grid, const signed char* givens);
+
+// Show whether the current marks still allow a solution
+void grid_set_solvable(grid_t* grid, bool solvable);
+
 void grid_draw(const grid_t* grid, SDL_Renderer* renderer);
 
+// Draw just the regions of a level into dst, needs no grid_t or textures.
+// The level must have its regions built, see level_build_regions
+void grid_draw_level(SDL_Renderer* renderer, const level_t* level, const SDL_FRect* dst);
+
 #endif /* __GRID_H */
\ No newline at end of file
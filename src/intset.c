@@ -1,4 +1,5 @@
 #include "intset.h"
+#include "mem.h"
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -23,10 +24,10 @@ static int next_pow2(int x) {
 bool intset_init(intset_t* s, int expected_count) {
     if (!s) return false;
     int cap = next_pow2(expected_count * 2 + 8); // load factor ~0.5
-    s->keys = (int*)malloc(sizeof(int) * cap);
-    s->used = (unsigned char*)malloc(sizeof(unsigned char) * cap);
+    s->keys = (int*)mem_malloc(sizeof(int) * cap);
+    s->used = (unsigned char*)mem_malloc(sizeof(unsigned char) * cap);
     if (!s->keys || !s->used) {
-        free(s->keys); free(s->used);
+        mem_free(s->keys); mem_free(s->used);
         return false;
     }
     memset(s->used, 0, cap);
@@ -37,8 +38,8 @@ bool intset_init(intset_t* s, int expected_count) {
 
 void intset_destroy(intset_t* s) {
     if (!s) return;
-    free(s->keys);
-    free(s->used);
+    mem_free(s->keys);
+    mem_free(s->used);
     s->keys = NULL;
     s->used = NULL;
     s->cap = 0;
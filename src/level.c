@@ -1,60 +1,61 @@
 #include "level.h"
 #include "vector.h"
 #include "vector2.h"
+#include "mem.h"
+#include "util.h"
 
-#include <malloc.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
-static
-void 
-shuffle_int_array(int* arr, int n) {
-	if (!arr || n <= 1) return;
-
-	for (int i = n - 1; i > 0; --i) {
-		int j = rand() % (i + 1); // random index from 0 to i
-
-		// swap arr[i] and arr[j]
-		int tmp = arr[i];
-		arr[i] = arr[j];
-		arr[j] = tmp;
-	}
-}
-
-static
 level_t*
-level_init(int rows, int cols) {
-	level_t *level = (level_t*)malloc(sizeof(level_t));
+level_create(int rows, int cols) {
+	level_t *level = (level_t*)mem_malloc(sizeof(level_t));
 	assert(level);
 
 	level->rows = rows;
 	level->cols = cols;
 
 	int size = rows * cols;
-	level->regions = (int*)malloc(size * sizeof(int));
+	level->regions = (int*)mem_malloc(size * sizeof(int));
 	assert(level->regions);
 	// Set all regions to -1
 	for (int i = 0; i < size; ++i) {
 		level->regions[i] = -1;
 	}
 
+	level->region_count = 0;
+	level->region_start = NULL;
+	level->region_cells = NULL;
+	level->adjacent_start = NULL;
+	level->adjacent = NULL;
+	level->colours = NULL;
+	level->borders = NULL;
+	level->border_count = 0;
+	level->capacity = 0;
+
 	return level;
 }
 
 static
-bool place_row(int row, int rows, int cols, int* columns, vector_t *queens) {
+bool place_row(int row, int rows, int cols, int* columns, vector_t *queens, unsigned* rng, level_stats_t* stats) {
+	stats->placement_nodes++;
+	if (row > stats->max_depth) {
+		stats->max_depth = row;
+	}
+
 	if (row == rows) {
 		return true;
 	}
 
-	int* col_order = (int*)malloc(cols * sizeof(int));
+	int* col_order = (int*)mem_malloc(cols * sizeof(int));
 	assert(col_order);
 
 	for (int i = 0; i < cols; ++i) {
 		col_order[i] = i;
 	}
-	shuffle_int_array(col_order, cols);
+	util_shuffle(col_order, cols, rng);
 
 	for (int i = 0; i < cols; ++i) {
 		int col = col_order[i];
@@ -78,32 +79,56 @@ bool place_row(int row, int rows, int cols, int* columns, vector_t *queens) {
 		vector2i queen = { row, col };
 		vector_pushback(queens, &queen, sizeof(queen));
 
-		if (place_row(row + 1, rows, cols, columns, queens)) {
-			free(col_order);
+		if (place_row(row + 1, rows, cols, columns, queens, rng, stats)) {
+			mem_free(col_order);
 			return true;
 		}
 
 		vector_popback(queens);
 		columns[col] = 0;
+		stats->backtracks++;
 	}
 	
-	free(col_order);
+	mem_free(col_order);
 	return false;
 }
 
 level_t *
-level_generate(int rows, int cols) {
-	level_t* level = level_init(rows, cols);
+level_generate(int rows, int cols, unsigned* rng, level_stats_t* out_stats) {
+	// Always count, copying out is cheaper than branching in place_row
+	level_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	double start = util_now_ms();
+
+	level_t* level = level_create(rows, cols);
 
 	vector_t* queens = vector_new(); // vector2i
-	int* columns = (int*)malloc(cols * sizeof(int));
+	int* columns = (int*)mem_malloc(cols * sizeof(int));
 	assert(columns);
 	// Set all colums to 0
 	for (int i = 0; i < cols; ++i) {
 		columns[i] = 0;
 	}
 
-	place_row(0, rows, cols, columns, queens);
+	double phase = util_now_ms();
+	bool placed = place_row(0, rows, cols, columns, queens, rng, &stats);
+	stats.placement_ms = util_now_ms() - phase;
+
+	// No way to place the queens (2x2, 3x3), so no regions either
+	if (!placed) {
+		mem_free(columns);
+		V_FOREACH(queens, vector2i, q, q_i) {
+			mem_free(q);
+		}
+		vector_destroy(queens);
+		level_destroy(level);
+
+		stats.total_ms = util_now_ms() - start;
+		if (out_stats) {
+			*out_stats = stats;
+		}
+		return NULL;
+	}
 
 	// One region per queen
 	int queens_size = vector_size(queens);
@@ -114,8 +139,9 @@ level_generate(int rows, int cols) {
 	}
 
 	// Flood fill
+	phase = util_now_ms();
 	int size = rows * cols;
-	int* queue = (int*)malloc(size * sizeof(int));
+	int* queue = (int*)mem_malloc(size * sizeof(int));
 	assert(queue);
 	int front = 0, back = 0;
 
@@ -130,6 +156,7 @@ level_generate(int rows, int cols) {
 
 	while (front < back) {
 		int idx = queue[front++];
+		stats.flood_cells++;
 		int r = idx / cols;
 		int c = idx % cols;
 
@@ -148,15 +175,206 @@ level_generate(int rows, int cols) {
 		}
 	}
 
-	free(queue);
-	free(columns);
+	stats.flood_ms = util_now_ms() - phase;
+
+	phase = util_now_ms();
+	level_build_regions(level);
+	stats.regions_ms = util_now_ms() - phase;
+
+	mem_free(queue);
+	mem_free(columns);
+	V_FOREACH(queens, vector2i, q, q_i) {
+		mem_free(q);
+	}
 	vector_destroy(queens);
 
+	stats.total_ms = util_now_ms() - start;
+	if (out_stats) {
+		*out_stats = stats;
+	}
+
 	return level;
 }
 
+level_t*
+level_clone(const level_t* level) {
+	level_t* copy = level_create(level->rows, level->cols);
+	memcpy(copy->regions, level->regions, level->rows * level->cols * sizeof(int));
+	level_build_regions(copy);
+	return copy;
+}
+
+#define LEVEL_PALETTE_SIZE 6
+
+/*
+ * Smallest-last greedy colouring: repeatedly take out a region of
+ * least remaining degree, then colour in reverse order. The region
+ * graph of a grid is planar, so this never needs more than 6 colours.
+ */
+static
+void
+colour_regions(level_t* level, int* degree, int* order) {
+	int n = level->region_count;
+
+	for (int g = 0; g < n; ++g) {
+		degree[g] = level->adjacent_start[g + 1] - level->adjacent_start[g];
+		level->colours[g] = -1; // -1 while still in the graph
+	}
+
+	for (int k = n - 1; k >= 0; --k) {
+		int best = -1;
+		for (int g = 0; g < n; ++g) {
+			if (level->colours[g] == -1 && (best == -1 || degree[g] < degree[best])) {
+				best = g;
+			}
+		}
+
+		order[k] = best;
+		level->colours[best] = -2;
+		for (int a = level->adjacent_start[best]; a < level->adjacent_start[best + 1]; ++a) {
+			degree[level->adjacent[a]]--;
+		}
+	}
+
+	for (int k = 0; k < n; ++k) {
+		int g = order[k];
+		unsigned used = 0;
+		for (int a = level->adjacent_start[g]; a < level->adjacent_start[g + 1]; ++a) {
+			int colour = level->colours[level->adjacent[a]];
+			if (colour >= 0) used |= 1u << colour;
+		}
+
+		int colour = 0;
+		while (colour < LEVEL_PALETTE_SIZE && (used & (1u << colour))) colour++;
+		level->colours[g] = colour < LEVEL_PALETTE_SIZE ? colour : g % LEVEL_PALETTE_SIZE;
+	}
+}
+
+/* Merge runs of unit edges where `differs` into segments. */
+static
+void
+build_borders(level_t* level) {
+	int rows = level->rows;
+	int cols = level->cols;
+	const int* regions = level->regions;
+	level->border_count = 0;
+
+	// Horizontal lines y = 0..rows
+	for (int y = 0; y <= rows; ++y) {
+		int run = -1;
+		for (int x = 0; x <= cols; ++x) {
+			bool differs = x < cols && (y == 0 || y == rows ||
+				regions[(y - 1) * cols + x] != regions[y * cols + x]);
+			if (differs && run < 0) {
+				run = x;
+			}
+			else if (!differs && run >= 0) {
+				level->borders[level->border_count++] = (level_edge_t){ run, y, x, y };
+				run = -1;
+			}
+		}
+	}
+
+	// Vertical lines x = 0..cols
+	for (int x = 0; x <= cols; ++x) {
+		int run = -1;
+		for (int y = 0; y <= rows; ++y) {
+			bool differs = y < rows && (x == 0 || x == cols ||
+				regions[y * cols + x - 1] != regions[y * cols + x]);
+			if (differs && run < 0) {
+				run = y;
+			}
+			else if (!differs && run >= 0) {
+				level->borders[level->border_count++] = (level_edge_t){ x, run, x, y };
+				run = -1;
+			}
+		}
+	}
+}
+
+void
+level_build_regions(level_t* level) {
+	int rows = level->rows;
+	int cols = level->cols;
+	int size = rows * cols;
+
+	if (size > level->capacity) {
+		// region_start, region_cells, adjacent_start, adjacent (4 per cell
+		// at most), colours and 3 scratch arrays share one block
+		mem_free(level->region_start);
+		mem_free(level->borders);
+		level->region_start = (int*)mem_malloc((11 * size + 2) * sizeof(int));
+		level->borders = (level_edge_t*)mem_malloc((rows * (cols + 1) + cols * (rows + 1)) * sizeof(level_edge_t));
+		assert(level->region_start && level->borders);
+		level->capacity = size;
+	}
+	level->region_cells = level->region_start + size + 1;
+	level->adjacent_start = level->region_cells + size;
+	level->adjacent = level->adjacent_start + size + 1;
+	level->colours = level->adjacent + 4 * size;
+	int* stamp = level->colours + size;
+	int* degree = stamp + size;
+	int* order = degree + size;
+
+	int n = 0;
+	for (int i = 0; i < size; ++i) {
+		assert(level->regions[i] >= 0);
+		if (level->regions[i] + 1 > n) n = level->regions[i] + 1;
+	}
+	level->region_count = n;
+
+	// Cell lists by counting sort
+	memset(level->region_start, 0, (n + 1) * sizeof(int));
+	for (int i = 0; i < size; ++i) {
+		level->region_start[level->regions[i] + 1]++;
+	}
+	for (int g = 0; g < n; ++g) {
+		level->region_start[g + 1] += level->region_start[g];
+	}
+	for (int g = 0; g < n; ++g) {
+		stamp[g] = level->region_start[g];
+	}
+	for (int i = 0; i < size; ++i) {
+		level->region_cells[stamp[level->regions[i]]++] = i;
+	}
+
+	// Neighbouring regions, stamp dedups within one region
+	int d[5] = { -1, 0, 1, 0, -1 };
+	for (int g = 0; g < n; ++g) {
+		stamp[g] = -1;
+	}
+	int count = 0;
+	for (int g = 0; g < n; ++g) {
+		level->adjacent_start[g] = count;
+		for (int k = level->region_start[g]; k < level->region_start[g + 1]; ++k) {
+			int idx = level->region_cells[k];
+			int r = idx / cols;
+			int c = idx % cols;
+
+			for (int i = 0; i < 4; ++i) {
+				int nr = r + d[i];
+				int nc = c + d[i + 1];
+				if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+					continue;
+
+				int h = level->regions[nr * cols + nc];
+				if (h != g && stamp[h] != g) {
+					stamp[h] = g;
+					level->adjacent[count++] = h;
+				}
+			}
+		}
+	}
+	level->adjacent_start[n] = count;
+
+	colour_regions(level, degree, order);
+	build_borders(level);
+}
+
 void
 level_destroy(level_t* level) {
-	free(level->regions);
-	free(level);
+	mem_free(level->region_start);
+	mem_free(level->borders);
+	mem_free(level->regions);
+	mem_free(level);
 }
\ No newline at end of file
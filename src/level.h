@@ -1,13 +1,54 @@
 #ifndef __LEVEL_H
 #define __LEVEL_H
 
+// Border segment between two regions or along the edge of the board,
+// in cell corner coordinates (x is the column, y the row)
+typedef struct {
+	int x0, y0;
+	int x1, y1;
+} level_edge_t;
+
 typedef struct {
 	int rows;
 	int cols;
 	int* regions;
+
+	// Derived from regions by level_build_regions
+	int region_count;
+	int* region_start;   // region_count + 1 offsets into region_cells
+	int* region_cells;   // cell indices grouped by region
+	int* adjacent_start; // region_count + 1 offsets into adjacent
+	int* adjacent;       // neighbouring regions of each region
+	int* colours;        // palette index per region, neighbours differ
+	level_edge_t* borders;
+	int border_count;
+	int capacity;        // cells the derived buffers can hold
 } level_t;
 
-level_t* level_generate(int rows, int cols);
+// Work done by one level_generate call
+typedef struct {
+	long long placement_nodes; // place_row calls
+	long long backtracks;      // queens taken back
+	int max_depth;             // deepest row reached
+	long long flood_cells;     // cells popped by the region flood fill
+	double placement_ms;
+	double flood_ms;
+	double regions_ms;         // level_build_regions
+	double total_ms;
+} level_stats_t;
+
+level_t* level_create(int rows, int cols);
+
+level_t* level_clone(const level_t* level);
+
+// Rebuild the derived region data, call after changing regions.
+// Region ids must be 0..region_count-1. Buffers only grow.
+void level_build_regions(level_t* level);
+
+// rng is a util_rand state, NULL draws from rand(). stats is optional,
+// pass NULL if not needed. Returns NULL if the board has no room for
+// one queen per row and column (2x2, 3x3)
+level_t* level_generate(int rows, int cols, unsigned* rng, level_stats_t* stats);
 
 void level_destroy(level_t* level);
 
@@ -0,0 +1,260 @@
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "level_client.h"
+#include "mem.h"
+#include "util.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LEVEL_CLIENT_SOCKETS 1
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// A fetch never blocks the caller for longer than this in total
+#define LEVEL_CLIENT_TIMEOUT_MS 200
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct level_client_t {
+	int fd;
+	char path[108];
+	bool pending;          // a request was sent and its answer not read yet
+	int pending_size;
+	int pending_stars;
+	unsigned char cells[LEVEL_PROTO_MAX_SIZE * LEVEL_PROTO_MAX_SIZE];
+};
+
+#ifdef LEVEL_CLIENT_SOCKETS
+
+static
+int
+_connect(const char* path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+	// Local connects complete at once, only the exchanges wait
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+// Waits for the socket with whatever is left until the deadline
+static
+bool
+_wait(int fd, short events, double deadline) {
+	for (;;) {
+		double left = deadline - util_now_ms();
+		if (left <= 0) return false;
+
+		struct pollfd pfd = { fd, events, 0 };
+		int ready = poll(&pfd, 1, (int)left + 1);
+		if (ready < 0 && errno == EINTR) continue;
+		return ready > 0;
+	}
+}
+
+static
+bool
+_send_all(int fd, const void* data, size_t size, double deadline) {
+	const char* p = (const char*)data;
+	while (size > 0) {
+		ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			if (!_wait(fd, POLLOUT, deadline)) return false;
+			continue;
+		}
+		if (n <= 0) return false;
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+static
+bool
+_recv_all(int fd, void* data, size_t size, double deadline) {
+	char* p = (char*)data;
+	while (size > 0) {
+		ssize_t n = recv(fd, p, size, 0);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			if (!_wait(fd, POLLIN, deadline)) return false;
+			continue;
+		}
+		if (n <= 0) return false;
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+// A timed out or garbled exchange leaves the stream out of step, so
+// drop the connection and reconnect on the next fetch
+static
+void
+_disconnect(level_client_t* client) {
+	if (client->fd >= 0) {
+		close(client->fd);
+		client->fd = -1;
+	}
+	client->pending = false;
+}
+
+static
+bool
+_request(level_client_t* client, int size, int stars, double deadline) {
+	level_request_t request = { LEVEL_PROTO_MAGIC, (uint8_t)size, (uint8_t)size, (uint8_t)stars, 0 };
+	if (!_send_all(client->fd, &request, sizeof(request), deadline)) {
+		_disconnect(client);
+		return false;
+	}
+	client->pending = true;
+	client->pending_size = size;
+	client->pending_stars = stars;
+	return true;
+}
+
+// Reads the answer to the pending request, region ids into cells.
+// Returns its status, -1 if the connection had to be dropped
+static
+int
+_receive(level_client_t* client, double deadline) {
+	level_response_t response;
+	if (!_recv_all(client->fd, &response, sizeof(response), deadline) ||
+		response.magic != LEVEL_PROTO_MAGIC) {
+		_disconnect(client);
+		return -1;
+	}
+	client->pending = false;
+	if (response.status != LEVEL_PROTO_OK) return response.status;
+
+	int size = client->pending_size;
+	if (response.rows != size || response.cols != size ||
+		!_recv_all(client->fd, client->cells, size * size, deadline)) {
+		_disconnect(client);
+		return -1;
+	}
+
+	// Exactly size distinct region ids, level_build_regions counts on it
+	bool used[LEVEL_PROTO_MAX_SIZE] = { false };
+	int region_count = 0;
+	for (int i = 0; i < size * size; ++i) {
+		unsigned char region = client->cells[i];
+		if (region >= size) {
+			_disconnect(client);
+			return -1;
+		}
+		if (!used[region]) region_count++;
+		used[region] = true;
+	}
+	if (region_count != size) {
+		_disconnect(client);
+		return -1;
+	}
+	return LEVEL_PROTO_OK;
+}
+
+#endif /* LEVEL_CLIENT_SOCKETS */
+
+level_client_t*
+level_client_connect(const char* path) {
+#ifdef LEVEL_CLIENT_SOCKETS
+	if (!path) path = getenv(LEVEL_PROTO_SOCKET_ENV);
+	if (!path || !*path) path = LEVEL_PROTO_DEFAULT_SOCKET;
+
+	int fd = _connect(path);
+	if (fd < 0) return NULL;
+
+	level_client_t* client = (level_client_t*)mem_calloc(1, sizeof(level_client_t));
+	assert(client);
+	client->fd = fd;
+	strcpy(client->path, path); // fits, _connect checked against sun_path
+	return client;
+#else
+	(void)path;
+	return NULL;
+#endif
+}
+
+void
+level_client_close(level_client_t* client) {
+	if (!client) return;
+#ifdef LEVEL_CLIENT_SOCKETS
+	_disconnect(client);
+#endif
+	mem_free(client);
+}
+
+level_t*
+level_client_fetch(level_client_t* client, int size, int stars) {
+#ifdef LEVEL_CLIENT_SOCKETS
+	if (!client || size < 1 || size > LEVEL_PROTO_MAX_SIZE || stars < 1 || stars > 255) return NULL;
+
+	double deadline = util_now_ms() + LEVEL_CLIENT_TIMEOUT_MS;
+	if (client->fd < 0) {
+		client->fd = _connect(client->path);
+		if (client->fd < 0) return NULL;
+	}
+
+	// A level prefetched for another size is of no use here
+	if (client->pending && (client->pending_size != size || client->pending_stars != stars) &&
+		_receive(client, deadline) < 0) {
+		return NULL;
+	}
+
+	// The prefetched answer may be stale, an empty pool could have
+	// refilled since, so that one gets a second request
+	bool prefetched = client->pending;
+	if (!prefetched && !_request(client, size, stars, deadline)) return NULL;
+	int status = _receive(client, deadline);
+	if (status == LEVEL_PROTO_EMPTY && prefetched) {
+		if (!_request(client, size, stars, deadline)) return NULL;
+		status = _receive(client, deadline);
+	}
+	if (status != LEVEL_PROTO_OK) return NULL;
+
+	level_t* level = level_create(size, size);
+	for (int i = 0; i < size * size; ++i) {
+		level->regions[i] = client->cells[i];
+	}
+	level_build_regions(level);
+
+	// Ask for the next one now, its answer waits in the socket while
+	// this level is played
+	_request(client, size, stars, deadline);
+	return level;
+#else
+	(void)client;
+	(void)size;
+	(void)stars;
+	return NULL;
+#endif
+}
@@ -0,0 +1,83 @@
+#ifndef __LEVEL_CLIENT_H
+#define __LEVEL_CLIENT_H
+
+#include "level.h"
+
+#include <stdint.h>
+
+/**********************************************************
+ * Level server protocol
+ *
+ * A local daemon keeps pools of verified levels and serves
+ * them over a Unix domain socket. Each request is one fixed
+ * size record; the response is a fixed header followed by
+ * rows * cols region ids, one byte each. Both ends run on the
+ * same host, so fields use native byte order. A connection
+ * may carry any number of requests.
+ **********************************************************/
+
+#define LEVEL_PROTO_MAGIC 0x31564c51u /* "QLV1" */
+#define LEVEL_PROTO_MAX_SIZE 16
+#define LEVEL_PROTO_DEFAULT_SOCKET "/tmp/queensd.sock"
+#define LEVEL_PROTO_SOCKET_ENV "QUEENS_LEVEL_SOCKET"
+
+typedef enum {
+	LEVEL_PROTO_OK,
+	LEVEL_PROTO_UNSUPPORTED, // no pool for this size and star count
+	LEVEL_PROTO_EMPTY,       // pool drained, generate locally
+	LEVEL_PROTO_BAD_REQUEST
+} level_proto_status_t;
+
+typedef struct {
+	uint32_t magic;
+	uint8_t rows;
+	uint8_t cols;
+	uint8_t stars;
+	uint8_t reserved;
+} level_request_t;
+
+typedef struct {
+	uint32_t magic;
+	uint8_t status;
+	uint8_t rows;
+	uint8_t cols;
+	uint8_t stars;
+} level_response_t;
+
+typedef struct level_client_t level_client_t;
+
+/**********************************************************
+ * \brief Connect to the level server
+ *
+ * \param path      socket path, NULL for $QUEENS_LEVEL_SOCKET
+ *                  or LEVEL_PROTO_DEFAULT_SOCKET
+ *
+ * \returns client, NULL if no server is listening or the
+ *          platform has no Unix domain sockets
+ **********************************************************/
+level_client_t* level_client_connect(const char* path);
+
+/**********************************************************
+ * \brief Close the connection and free memory
+ *
+ * \param client    this
+ **********************************************************/
+void level_client_close(level_client_t* client);
+
+/**********************************************************
+ * \brief Fetch a level from the server's pool
+ *
+ * Waits at most 200 ms in all. After a level is served the
+ * next one of the same size is requested right away, so the
+ * following fetch usually finds it already waiting.
+ *
+ * \param client    this
+ * \param size      rows and columns
+ * \param stars     queens per row, column and region
+ *
+ * \returns newly created level with regions built, NULL if the
+ *          server could not serve one in time
+ **********************************************************/
+level_t* level_client_fetch(level_client_t* client, int size, int stars);
+
+#endif /* __LEVEL_CLIENT_H */
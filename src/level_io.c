@@ -0,0 +1,445 @@
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "level_io.h"
+#include "mem.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LEVEL_IO_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define READER_CHUNK (64 * 1024)
+
+static const char symbols[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+	"abcdefghijklmnopqrstuvwxyz"
+	"0123456789";
+
+struct level_reader_t {
+	// Whole input (memory, mmap) or a sliding window over a stream
+	const char* data;
+	size_t size;
+	size_t pos;
+	int line;
+
+	FILE* stream;
+	bool owns_stream;
+	bool eof;
+	char* buffer;
+	size_t buffer_cap;
+
+	void* map;
+	size_t map_size;
+
+	// Reused by every puzzle
+	level_t* level;
+	int region_cap;
+	int* queue;
+	unsigned char* seen;
+	int scratch_cap;
+
+	bool failed;
+	char error[128];
+};
+
+static
+int
+_symbol_index(char c) {
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return 26 + c - 'a';
+	if (c >= '0' && c <= '9') return 52 + c - '0';
+	return -1;
+}
+
+static
+level_reader_t*
+_reader_new(void) {
+	level_reader_t* reader = (level_reader_t*)mem_calloc(1, sizeof(level_reader_t));
+	assert(reader);
+	reader->level = level_create(1, 1);
+	reader->region_cap = 1;
+	return reader;
+}
+
+level_reader_t*
+level_reader_open_memory(const char* data, size_t size) {
+	level_reader_t* reader = _reader_new();
+	reader->data = data;
+	reader->size = size;
+	return reader;
+}
+
+level_reader_t*
+level_reader_open_stream(FILE* file) {
+	level_reader_t* reader = _reader_new();
+	reader->stream = file;
+	reader->buffer_cap = READER_CHUNK;
+	reader->buffer = (char*)mem_malloc(reader->buffer_cap);
+	assert(reader->buffer);
+	reader->data = reader->buffer;
+	return reader;
+}
+
+level_reader_t*
+level_reader_open(const char* path) {
+#ifdef LEVEL_IO_MMAP
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return NULL;
+	}
+
+	if (st.st_size == 0) {
+		close(fd);
+		return level_reader_open_memory("", 0);
+	}
+
+	void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return NULL;
+	posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+	level_reader_t* reader = level_reader_open_memory((const char*)map, (size_t)st.st_size);
+	reader->map = map;
+	reader->map_size = (size_t)st.st_size;
+	return reader;
+#else
+	FILE* file = fopen(path, "rb");
+	if (!file) return NULL;
+
+	level_reader_t* reader = level_reader_open_stream(file);
+	reader->owns_stream = true;
+	return reader;
+#endif
+}
+
+void
+level_reader_close(level_reader_t* reader) {
+	if (!reader) return;
+
+#ifdef LEVEL_IO_MMAP
+	if (reader->map) {
+		munmap(reader->map, reader->map_size);
+	}
+#endif
+	if (reader->owns_stream) {
+		fclose(reader->stream);
+	}
+
+	mem_free(reader->buffer);
+	level_destroy(reader->level);
+	mem_free(reader->queue);
+	mem_free(reader->seen);
+	mem_free(reader);
+}
+
+const char*
+level_reader_error(const level_reader_t* reader) {
+	return reader->failed ? reader->error : NULL;
+}
+
+// Slide the unread tail to the front of the window and read more
+static
+void
+_fill(level_reader_t* reader) {
+	size_t left = reader->size - reader->pos;
+	memmove(reader->buffer, reader->buffer + reader->pos, left);
+	reader->size = left;
+	reader->pos = 0;
+
+	// A line longer than the window: grow it
+	if (reader->size == reader->buffer_cap) {
+		reader->buffer_cap *= 2;
+		reader->buffer = (char*)mem_realloc(reader->buffer, reader->buffer_cap);
+		assert(reader->buffer);
+	}
+	reader->data = reader->buffer;
+
+	size_t read = fread(reader->buffer + reader->size, 1, reader->buffer_cap - reader->size, reader->stream);
+	if (read == 0) {
+		reader->eof = true;
+	}
+	reader->size += read;
+}
+
+// Next line without its terminator, valid until the next call
+static
+bool
+_next_line(level_reader_t* reader, const char** out, size_t* out_len) {
+	const char* start;
+	size_t len;
+
+	for (;;) {
+		start = reader->data + reader->pos;
+		size_t avail = reader->size - reader->pos;
+
+		const char* nl = (const char*)memchr(start, '\n', avail);
+		if (nl) {
+			len = (size_t)(nl - start);
+			reader->pos += len + 1;
+			break;
+		}
+		if (reader->stream && !reader->eof) {
+			_fill(reader);
+			continue;
+		}
+		if (avail == 0) return false;
+
+		len = avail;
+		reader->pos = reader->size;
+		break;
+	}
+
+	while (len > 0 && (start[len - 1] == '\r' || start[len - 1] == ' ' || start[len - 1] == '\t')) {
+		len--;
+	}
+
+	reader->line++;
+	*out = start;
+	*out_len = len;
+	return true;
+}
+
+static
+void
+_fail(level_reader_t* reader, const char* fmt, ...) {
+	int n = snprintf(reader->error, sizeof(reader->error), "line %d: ", reader->line);
+
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(reader->error + n, sizeof(reader->error) - n, fmt, args);
+	va_end(args);
+
+	reader->failed = true;
+}
+
+static
+void
+_skip_block(level_reader_t* reader) {
+	const char* line;
+	size_t len;
+	while (_next_line(reader, &line, &len) && len > 0) {
+	}
+}
+
+static
+void
+_parse_meta(const char* line, size_t len, level_meta_t* meta) {
+	const char* colon = (const char*)memchr(line, ':', len);
+	size_t key_len = (size_t)(colon - line);
+	while (key_len > 0 && line[key_len - 1] == ' ') key_len--;
+
+	const char* value = colon + 1;
+	size_t value_len = len - (size_t)(value - line);
+	while (value_len > 0 && *value == ' ') {
+		value++;
+		value_len--;
+	}
+
+	if (key_len == 4 && memcmp(line, "name", 4) == 0) {
+		if (value_len >= LEVEL_IO_NAME_MAX) value_len = LEVEL_IO_NAME_MAX - 1;
+		memcpy(meta->name, value, value_len);
+		meta->name[value_len] = '\0';
+	}
+	else if (key_len == 5 && memcmp(line, "stars", 5) == 0) {
+		int stars = 0;
+		for (size_t i = 0; i < value_len && value[i] >= '0' && value[i] <= '9'; ++i) {
+			stars = stars * 10 + (value[i] - '0');
+		}
+		meta->stars = stars;
+	}
+}
+
+// Every region must be one 4-connected component
+static
+int
+_find_split_region(level_reader_t* reader) {
+	const level_t* level = reader->level;
+	int rows = level->rows;
+	int cols = level->cols;
+	int size = rows * cols;
+
+	if (size > reader->scratch_cap) {
+		reader->queue = (int*)mem_realloc(reader->queue, size * sizeof(int));
+		reader->seen = (unsigned char*)mem_realloc(reader->seen, size);
+		assert(reader->queue && reader->seen);
+		reader->scratch_cap = size;
+	}
+	memset(reader->seen, 0, size);
+
+	unsigned char visited[LEVEL_IO_MAX_REGIONS] = { 0 };
+	int d[5] = { -1, 0, 1, 0, -1 };
+
+	for (int i = 0; i < size; ++i) {
+		if (reader->seen[i]) continue;
+
+		int region = level->regions[i];
+		if (visited[region]) return region;
+		visited[region] = 1;
+
+		int front = 0, back = 0;
+		reader->queue[back++] = i;
+		reader->seen[i] = 1;
+
+		while (front < back) {
+			int idx = reader->queue[front++];
+			int r = idx / cols;
+			int c = idx % cols;
+
+			for (int k = 0; k < 4; ++k) {
+				int nr = r + d[k];
+				int nc = c + d[k + 1];
+				if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+					continue;
+
+				int nidx = nr * cols + nc;
+				if (!reader->seen[nidx] && level->regions[nidx] == region) {
+					reader->seen[nidx] = 1;
+					reader->queue[back++] = nidx;
+				}
+			}
+		}
+	}
+
+	return -1;
+}
+
+level_t*
+level_reader_next(level_reader_t* reader, level_meta_t* meta) {
+	level_meta_t scratch_meta;
+	if (!meta) meta = &scratch_meta;
+	meta->name[0] = '\0';
+	meta->stars = 1;
+
+	reader->failed = false;
+	reader->error[0] = '\0';
+
+	level_t* level = reader->level;
+	int rows = 0;
+	int cols = 0;
+	int region_count = 0;
+	int dense[LEVEL_IO_MAX_REGIONS];
+	char symbol_of[LEVEL_IO_MAX_REGIONS];
+
+	const char* line;
+	size_t len;
+	while (_next_line(reader, &line, &len)) {
+		if (len == 0) {
+			if (rows > 0) break;
+			continue;
+		}
+		if (line[0] == '#') continue;
+
+		if (rows == 0 && memchr(line, ':', len)) {
+			_parse_meta(line, len, meta);
+			continue;
+		}
+
+		if (rows == 0) {
+			cols = (int)len;
+			for (int i = 0; i < LEVEL_IO_MAX_REGIONS; ++i) {
+				dense[i] = -1;
+			}
+		}
+		else if ((int)len != cols) {
+			_fail(reader, "expected %d columns, got %d", cols, (int)len);
+			_skip_block(reader);
+			return NULL;
+		}
+
+		// Grows by doubling, so only the first few puzzles allocate
+		int needed = (rows + 1) * cols;
+		if (needed > reader->region_cap) {
+			int cap = reader->region_cap < 256 ? 256 : reader->region_cap;
+			while (cap < needed) cap *= 2;
+			level->regions = (int*)mem_realloc(level->regions, cap * sizeof(int));
+			assert(level->regions);
+			reader->region_cap = cap;
+		}
+
+		int* out = level->regions + rows * cols;
+		for (int c = 0; c < cols; ++c) {
+			int symbol = _symbol_index(line[c]);
+			if (symbol < 0) {
+				_fail(reader, "invalid region symbol '%c'", line[c]);
+				_skip_block(reader);
+				return NULL;
+			}
+			if (dense[symbol] < 0) {
+				symbol_of[region_count] = line[c];
+				dense[symbol] = region_count++;
+			}
+			out[c] = dense[symbol];
+		}
+		rows++;
+	}
+
+	if (rows == 0) return NULL;
+
+	level->rows = rows;
+	level->cols = cols;
+
+	if (rows != cols) {
+		_fail(reader, "grid is %dx%d, expected a square", rows, cols);
+		return NULL;
+	}
+	if (region_count != rows) {
+		_fail(reader, "%d regions, expected %d", region_count, rows);
+		return NULL;
+	}
+	if (meta->stars < 1) {
+		_fail(reader, "stars must be at least 1");
+		return NULL;
+	}
+
+	int split = _find_split_region(reader);
+	if (split >= 0) {
+		_fail(reader, "region '%c' is not contiguous", symbol_of[split]);
+		return NULL;
+	}
+
+	// The rest of the region metadata is left to consumers that draw
+	// or solve, building it here would slow plain conversion down
+	level->region_count = region_count;
+	return level;
+}
+
+bool
+level_write(FILE* file, const level_t* level, const level_meta_t* meta) {
+	if (meta) {
+		if (meta->name[0] && fprintf(file, "name: %s\n", meta->name) < 0) return false;
+		if (meta->stars > 1 && fprintf(file, "stars: %d\n", meta->stars) < 0) return false;
+	}
+
+	char row[256];
+	for (int r = 0; r < level->rows; ++r) {
+		int n = 0;
+		for (int c = 0; c < level->cols; ++c) {
+			int region = level->regions[r * level->cols + c];
+			if (region < 0 || region >= LEVEL_IO_MAX_REGIONS) return false;
+
+			row[n++] = symbols[region];
+			if (n == (int)sizeof(row)) {
+				if (fwrite(row, 1, n, file) != (size_t)n) return false;
+				n = 0;
+			}
+		}
+		row[n++] = '\n';
+		if (fwrite(row, 1, n, file) != (size_t)n) return false;
+	}
+
+	return fputc('\n', file) != EOF;
+}
@@ -0,0 +1,110 @@
+#ifndef __LEVEL_IO_H
+#define __LEVEL_IO_H
+
+#include "level.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**********************************************************
+ * Plain text level format
+ *
+ *   # comment
+ *   name: Daily 42
+ *   stars: 1
+ *   AABBB
+ *   ACCBD
+ *   ...
+ *
+ * One puzzle per block, blocks separated by blank lines.
+ * Optional "key: value" metadata lines come before the grid,
+ * unknown keys are ignored. Each grid character names a
+ * region: A-Z, a-z then 0-9, so at most 62 regions.
+ **********************************************************/
+
+#define LEVEL_IO_NAME_MAX 64
+#define LEVEL_IO_MAX_REGIONS 62
+
+typedef struct {
+	char name[LEVEL_IO_NAME_MAX];
+	int stars;
+} level_meta_t;
+
+typedef struct level_reader_t level_reader_t;
+
+/**********************************************************
+ * \brief Open a level file, memory mapped where supported
+ *
+ * \param path      file to read
+ *
+ * \returns reader, NULL if the file could not be opened
+ **********************************************************/
+level_reader_t* level_reader_open(const char* path);
+
+/**********************************************************
+ * \brief Read levels from a stream in fixed size chunks
+ *
+ * \param file      stream, not closed by the reader
+ *
+ * \returns reader
+ **********************************************************/
+level_reader_t* level_reader_open_stream(FILE* file);
+
+/**********************************************************
+ * \brief Read levels from memory
+ *
+ * \param data      text, must outlive the reader
+ * \param size      size of text in bytes
+ *
+ * \returns reader
+ **********************************************************/
+level_reader_t* level_reader_open_memory(const char* data, size_t size);
+
+/**********************************************************
+ * \brief Free reader memory and unmap its input
+ *
+ * \param reader    this
+ **********************************************************/
+void level_reader_close(level_reader_t* reader);
+
+/**********************************************************
+ * \brief Parse and validate the next puzzle
+ *
+ * Region ids are renumbered densely in order of first
+ * appearance. The returned level is owned by the reader and
+ * reused by the next call, so no memory is allocated once its
+ * buffers are large enough. Only region_count of the derived
+ * region data is set, call level_build_regions on the level
+ * before drawing it.
+ *
+ * \param reader    this
+ * \param meta      optional, receives the puzzle metadata
+ *
+ * \returns level, NULL at end of input or on an invalid puzzle;
+ *          after an invalid puzzle level_reader_error is set and
+ *          the next call resumes with the following block
+ **********************************************************/
+level_t* level_reader_next(level_reader_t* reader, level_meta_t* meta);
+
+/**********************************************************
+ * \brief Describe why the last level_reader_next failed
+ *
+ * \param reader    this
+ *
+ * \returns message with line number, NULL if it did not fail
+ **********************************************************/
+const char* level_reader_error(const level_reader_t* reader);
+
+/**********************************************************
+ * \brief Write a puzzle block
+ *
+ * \param file      output stream
+ * \param level     level with at most 62 regions
+ * \param meta      optional metadata to write first
+ *
+ * \returns false on write error or too many regions
+ **********************************************************/
+bool level_write(FILE* file, const level_t* level, const level_meta_t* meta);
+
+#endif /* __LEVEL_IO_H */
@@ -3,7 +3,12 @@
 #include <SDL3/SDL_main.h>
 #include <SDL3_image/SDL_image.h>
 
+#include "checker.h"
 #include "grid.h"
+#include "level_client.h"
+#include "level_io.h"
+#include "mem.h"
+#include "session.h"
 #include <stdio.h>
 
 
@@ -14,11 +19,122 @@
 #define WINDOW_WIDTH (GRID_WIDTH * CELL_SIZE)
 #define WINDOW_HEIGHT (GRID_HEIGHT * CELL_SIZE)
 
+#define CHECKPOINT_INTERVAL_MS 3000
+
 /* We will use this renderer to draw into this window every frame. */
 static SDL_Window* window = NULL;
 static SDL_Renderer* renderer = NULL;
 static grid_t* grid = NULL;
 
+/* Allocations since the end of the previous frame, events included. */
+static mem_scope_t frame_scope;
+
+/*
+ * Render on demand: frames are only drawn when something changed, and
+ * SDL sleeps until the next event in between. --always-render restores
+ * the old behaviour of drawing every iteration.
+ */
+static bool always_render = false;
+static bool redraw = true;
+static Uint64 iterations = 0;
+static Uint64 frames_rendered = 0;
+
+/* Checks in the background whether the board can still be solved. */
+static checker_t* checker = NULL;
+static bool board_changed = false;
+
+/* Levels given on the command line, played before generated ones. */
+static level_reader_t* level_file = NULL;
+
+/* Shared pool of pre-generated levels, NULL when no server is running. */
+static level_client_t* level_server = NULL;
+
+/*
+ * The level and board survive a restart: saved in full on quit, with
+ * the changed cells appended a few seconds after each edit.
+ */
+static session_t* session = NULL;
+static unsigned level_seed = 0;
+static Uint32 checkpoint_event = 0;
+static bool checkpoint_pending = false;
+
+/* Scales the board to the window whatever the level size. */
+static void show_level(const level_t* level, int stars) {
+    float cell_size = WINDOW_WIDTH / (float)SDL_max(level->rows, level->cols);
+    if (!grid) {
+        grid = grid_create(renderer, level, stars, cell_size);
+    }
+    else {
+        grid_reset(grid, level, stars, cell_size);
+    }
+
+    if (checker) {
+        checker_set_level(checker, level, stars);
+    }
+    board_changed = false;
+}
+
+static void next_level(void) {
+    while (level_file) {
+        level_meta_t meta;
+        const level_t* level = level_reader_next(level_file, &meta);
+        if (!level) {
+            const char* error = level_reader_error(level_file);
+            if (error) {
+                SDL_Log("Skipping invalid level: %s", error);
+                continue;
+            }
+            level_reader_close(level_file);
+            level_file = NULL;
+            break;
+        }
+
+        show_level(level, meta.stars);
+        session_begin(session, level, meta.stars, 0);
+        return;
+    }
+
+    /* The server answers at once, an empty pool means generate here. */
+    level_t* level = level_client_fetch(level_server, GRID_WIDTH, 1);
+    level_seed = 0;
+    if (!level) {
+        /* Seeded per level, so srand(level_seed) regenerates it. */
+        level_seed = (unsigned)rand() | 1;
+        srand(level_seed);
+        level = level_generate(GRID_WIDTH, GRID_HEIGHT, NULL, NULL);
+    }
+    SDL_assert_always(level);  /* GRID_WIDTH always has a solution */
+    show_level(level, 1);
+    session_begin(session, level, 1, level_seed);
+    level_destroy(level);
+}
+
+/* Picks up the level and board of the last run, if there is one. */
+static bool resume_session(void) {
+    const signed char* givens;
+    int stars;
+    level_t* level = session_load(session, &givens, &stars, &level_seed);
+    if (!level) {
+        return false;
+    }
+
+    show_level(level, stars);
+    grid_restore(grid, givens);
+    level_destroy(level);
+
+    /* Let the checker look at the restored board. */
+    board_changed = true;
+    return true;
+}
+
+static Uint32 SDLCALL checkpoint_timer(void* userdata, SDL_TimerID timer, Uint32 interval) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = checkpoint_event;
+    SDL_PushEvent(&event);
+    return 0;  /* one shot, the next edit arms it again */
+}
+
 /* This function runs once at startup. */
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
     SDL_SetAppMetadata("Queens", "1.0", "com.caaallum.queens");
@@ -34,13 +150,54 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
     }
     SDL_SetRenderLogicalPresentation(renderer, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_LOGICAL_PRESENTATION_LETTERBOX);
 
+    for (int i = 1; i < argc; ++i) {
+        if (SDL_strcmp(argv[i], "--always-render") == 0) {
+            always_render = true;
+        }
+        else if (!level_file) {
+            level_file = level_reader_open(argv[i]);
+            if (!level_file) {
+                SDL_Log("Couldn't open level file %s", argv[i]);
+            }
+        }
+    }
+
+    /* Only call SDL_AppIterate after events arrive, not at a fixed rate. */
+    if (!always_render) {
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, "waitevent");
+    }
+
     srand((unsigned)time(NULL));
 
-    level_t* level = level_generate(GRID_WIDTH, GRID_HEIGHT);
+    level_server = level_client_connect(NULL);
+    if (level_server) {
+        SDL_Log("Fetching levels from the level server");
+    }
+
+    checker = checker_create();
+    if (!checker) {
+        SDL_Log("Couldn't start solvability checker: %s", SDL_GetError());
+    }
 
-	grid = grid_create(renderer, level, 80.0f);
+    char* pref_path = SDL_GetPrefPath("caaallum", "queens");
+    if (pref_path) {
+        char session_path[1024];
+        SDL_snprintf(session_path, sizeof(session_path), "%ssession.bin", pref_path);
+        SDL_free(pref_path);
 
-    level_destroy(level);
+        session = session_create(session_path);
+        checkpoint_event = SDL_RegisterEvents(1);
+    }
+    else {
+        SDL_Log("Couldn't find a place to save the session: %s", SDL_GetError());
+    }
+
+    /* Levels named on the command line come before the saved one. */
+    if (level_file || !session || !resume_session()) {
+        next_level();
+    }
+
+    mem_scope_begin(&frame_scope);
 
     return SDL_APP_CONTINUE;  /* carry on with the program! */
 }
@@ -51,22 +208,89 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
         return SDL_APP_SUCCESS;  /* end the program, reporting success to the OS. */
     }
 
-	grid_handle_event(grid, event);
+    if (checkpoint_event && event->type == checkpoint_event) {
+        checkpoint_pending = false;
+        session_checkpoint(session, grid_snapshot(grid));
+    }
+
+    bool solvable;
+    if (checker && checker_result(checker, event, &solvable)) {
+        grid_set_solvable(grid, solvable);
+        redraw = true;
+    }
+
+    if (grid_handle_event(grid, event)) {
+        board_changed = true;
+        redraw = true;
+    }
+
+    /* Window shown, exposed, resized, moved between displays... */
+    if (event->type >= SDL_EVENT_WINDOW_FIRST && event->type <= SDL_EVENT_WINDOW_LAST) {
+        redraw = true;
+    }
 
     return SDL_APP_CONTINUE;  /* carry on with the program! */
 }
 
+/* Closes the allocation accounting of one iteration, drawn or not. */
+static void end_frame(bool level_changed) {
+#ifdef QUEENS_ALLOC_DEBUG
+    /* Steady-state frames must not touch the heap. */
+    mem_stats_t frame;
+    mem_scope_end(&frame_scope, &frame);
+    if (!level_changed && frame.count != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Steady-state frame allocated %lld times (%lld bytes)", frame.count, frame.bytes);
+        SDL_assert_always(frame.count == 0);
+    }
+#endif
+    mem_scope_begin(&frame_scope);
+}
+
 /* This function runs once per frame, and is the heart of the program. */
 SDL_AppResult SDL_AppIterate(void* appstate) {
-    const double now = ((double)SDL_GetTicks()) / 1000.0;  /* convert from milliseconds to seconds. */
+    bool level_changed = false;
+
+    iterations++;
+
+    if (grid_update(grid)) {
+        board_changed = true;
+        redraw = true;
+    }
+
+    /* One check per batch of input, it cancels the previous one. */
+    if (board_changed && checker) {
+        checker_submit(checker, grid_snapshot(grid));
+    }
+    if (board_changed && checkpoint_event && !checkpoint_pending) {
+        checkpoint_pending = SDL_AddTimer(CHECKPOINT_INTERVAL_MS, checkpoint_timer, NULL) != 0;
+    }
+    board_changed = false;
 
     if (grid_check_win(grid)) {
         printf("Level complete... Generating new\n");
-        level_t* level = level_generate(GRID_WIDTH, GRID_HEIGHT);
-        grid_reset(grid, level, 80.0f);
-        level_destroy(level);
+
+        mem_scope_t scope;
+        mem_scope_begin(&scope);
+
+        next_level();
+
+#ifdef QUEENS_ALLOC_DEBUG
+        mem_stats_t change;
+        mem_scope_end(&scope, &change);
+        SDL_Log("Level change: %lld allocations, %lld bytes, %lld frees", change.count, change.bytes, change.frees);
+#endif
+
+        /* Draw the new level now, the next iteration may be a long way off. */
+        level_changed = true;
+        redraw = true;
+    }
+
+    if (!redraw && !always_render) {
+        end_frame(level_changed);
         return SDL_APP_CONTINUE;
     }
+    redraw = false;
+    frames_rendered++;
 
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255); // Black background
     
@@ -78,11 +302,26 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
     /* put the newly-cleared rendering on the screen. */
     SDL_RenderPresent(renderer);
 
+    end_frame(level_changed);
+
     return SDL_APP_CONTINUE;  /* carry on with the program! */
 }
 
 /* This function runs once at shutdown. */
 void SDL_AppQuit(void* appstate, SDL_AppResult result) {
+    const double seconds = ((double)SDL_GetTicks()) / 1000.0;  /* convert from milliseconds to seconds. */
+    SDL_Log("Rendered %llu frames in %llu iterations over %.1f s",
+        (unsigned long long)frames_rendered, (unsigned long long)iterations, seconds);
+
+    checker_destroy(checker);
+    level_reader_close(level_file);
+    level_client_close(level_server);
+
+    if (session && grid) {
+        session_save(session, grid_snapshot(grid));
+    }
+    session_destroy(session);
+
     /* SDL will clean up the window/renderer for us. */
 }
 
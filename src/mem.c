@@ -0,0 +1,76 @@
+#include "mem.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define MEM_THREAD_LOCAL __declspec(thread)
+#else
+#define MEM_THREAD_LOCAL _Thread_local
+#endif
+
+static mem_hooks_t hooks = { malloc, realloc, free };
+static MEM_THREAD_LOCAL mem_stats_t stats;
+
+void
+mem_set_hooks(const mem_hooks_t* new_hooks) {
+	if (new_hooks) {
+		hooks = *new_hooks;
+	}
+	else {
+		hooks.malloc_fn = malloc;
+		hooks.realloc_fn = realloc;
+		hooks.free_fn = free;
+	}
+}
+
+void*
+mem_malloc(size_t size) {
+	stats.count++;
+	stats.bytes += (long long)size;
+	return hooks.malloc_fn(size);
+}
+
+void*
+mem_calloc(size_t count, size_t size) {
+	if (size != 0 && count > (size_t)-1 / size) {
+		return NULL;
+	}
+
+	void* ptr = mem_malloc(count * size);
+	if (ptr) {
+		memset(ptr, 0, count * size);
+	}
+	return ptr;
+}
+
+void*
+mem_realloc(void* ptr, size_t size) {
+	stats.count++;
+	stats.bytes += (long long)size;
+	return hooks.realloc_fn(ptr, size);
+}
+
+void
+mem_free(void* ptr) {
+	if (!ptr) return;
+	stats.frees++;
+	hooks.free_fn(ptr);
+}
+
+void
+mem_get_stats(mem_stats_t* out) {
+	*out = stats;
+}
+
+void
+mem_scope_begin(mem_scope_t* scope) {
+	scope->start = stats;
+}
+
+void
+mem_scope_end(const mem_scope_t* scope, mem_stats_t* out) {
+	out->count = stats.count - scope->start.count;
+	out->bytes = stats.bytes - scope->start.bytes;
+	out->frees = stats.frees - scope->start.frees;
+}
@@ -0,0 +1,68 @@
+#ifndef __MEM_H
+#define __MEM_H
+
+#include <stddef.h>
+
+/**********************************************************
+ * Allocation hooks
+ *
+ * Every heap allocation made by the game goes through these
+ * wrappers so it can be counted. Counters are per thread, so
+ * background work does not show up in the frame loop.
+ **********************************************************/
+
+typedef struct {
+	long long count;   // allocations, including reallocs
+	long long bytes;   // bytes requested by those allocations
+	long long frees;
+} mem_stats_t;
+
+typedef struct {
+	void* (*malloc_fn)(size_t size);
+	void* (*realloc_fn)(void* ptr, size_t size);
+	void (*free_fn)(void* ptr);
+} mem_hooks_t;
+
+typedef struct {
+	mem_stats_t start;
+} mem_scope_t;
+
+/**********************************************************
+ * \brief Replace the underlying allocator
+ *
+ * \param hooks     allocator functions, NULL restores the C
+ *                  runtime allocator
+ **********************************************************/
+void mem_set_hooks(const mem_hooks_t* hooks);
+
+void* mem_malloc(size_t size);
+
+void* mem_calloc(size_t count, size_t size);
+
+void* mem_realloc(void* ptr, size_t size);
+
+void mem_free(void* ptr);
+
+/**********************************************************
+ * \brief Get counters of the calling thread since start up
+ *
+ * \param out       receives the counters
+ **********************************************************/
+void mem_get_stats(mem_stats_t* out);
+
+/**********************************************************
+ * \brief Start measuring an operation or a frame
+ *
+ * \param scope     this
+ **********************************************************/
+void mem_scope_begin(mem_scope_t* scope);
+
+/**********************************************************
+ * \brief Get counters since mem_scope_begin
+ *
+ * \param scope     this
+ * \param out       receives the difference
+ **********************************************************/
+void mem_scope_end(const mem_scope_t* scope, mem_stats_t* out);
+
+#endif /* __MEM_H */
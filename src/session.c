@@ -0,0 +1,331 @@
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "session.h"
+#include "mem.h"
+#include "stars.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SESSION_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SESSION_MAGIC 0x31535351u /* "QSS1" */
+#define SESSION_VERSION 2
+#define SESSION_MAX_REGIONS 256
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t undo; // position in the undo history, the game has none yet
+	uint16_t rows;
+	uint16_t cols;
+	uint16_t stars;
+	uint16_t reserved;
+	uint32_t seed;
+} session_header_t;
+
+struct session_t {
+	char* path;
+	char* temp_path;
+	FILE* log;             // appends records after the last rewrite
+	bool active;           // a level was begun or loaded
+	session_header_t header;
+	int cells;
+	int capacity;
+	unsigned char* regions;
+	signed char* saved;    // board as the file has it
+	uint32_t* records;     // scratch for one checkpoint
+	int record_count;      // records in the file
+};
+
+static
+void
+_reserve(session_t* session, int cells) {
+	if (cells <= session->capacity) return;
+
+	session->regions = (unsigned char*)mem_realloc(session->regions, cells);
+	session->saved = (signed char*)mem_realloc(session->saved, cells);
+	session->records = (uint32_t*)mem_realloc(session->records, cells * sizeof(uint32_t));
+	assert(session->regions && session->saved && session->records);
+	session->capacity = cells;
+}
+
+// Header, regions and board into a temporary file, then swapped in
+// whole so a crash never leaves half a snapshot behind
+static
+bool
+_write_base(session_t* session) {
+	if (session->log) {
+		fclose(session->log);
+		session->log = NULL;
+	}
+	session->record_count = 0;
+
+	FILE* file = fopen(session->temp_path, "wb");
+	if (!file) return false;
+
+	bool ok = fwrite(&session->header, sizeof(session->header), 1, file) == 1 &&
+		fwrite(session->regions, 1, session->cells, file) == (size_t)session->cells &&
+		fwrite(session->saved, 1, session->cells, file) == (size_t)session->cells;
+	ok = fclose(file) == 0 && ok;
+
+#ifdef _WIN32
+	if (ok) remove(session->path); // rename does not replace files here
+#endif
+	if (!ok || rename(session->temp_path, session->path) != 0) {
+		remove(session->temp_path);
+		return false;
+	}
+
+	session->log = fopen(session->path, "ab");
+	return session->log != NULL;
+}
+
+static
+bool
+_read_file(const char* path, const unsigned char** data, size_t* size, void** map) {
+#ifdef SESSION_MMAP
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) return false;
+
+	*data = (const unsigned char*)mapped;
+	*size = (size_t)st.st_size;
+	*map = mapped;
+	return true;
+#else
+	FILE* file = fopen(path, "rb");
+	if (!file) return false;
+
+	size_t cap = 4096;
+	size_t len = 0;
+	unsigned char* buffer = (unsigned char*)mem_malloc(cap);
+	assert(buffer);
+	for (;;) {
+		len += fread(buffer + len, 1, cap - len, file);
+		if (len < cap) break;
+		cap *= 2;
+		buffer = (unsigned char*)mem_realloc(buffer, cap);
+		assert(buffer);
+	}
+	fclose(file);
+
+	*data = buffer;
+	*size = len;
+	*map = buffer;
+	return true;
+#endif
+}
+
+static
+void
+_release_file(void* map, size_t size) {
+#ifdef SESSION_MMAP
+	munmap(map, size);
+#else
+	(void)size;
+	mem_free(map);
+#endif
+}
+
+// Copies a valid snapshot into the session buffers, returns the
+// number of bytes of it that are intact
+static
+size_t
+_parse(session_t* session, const unsigned char* data, size_t size) {
+	session_header_t header;
+	if (size < sizeof(header)) return 0;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != SESSION_MAGIC || header.version != SESSION_VERSION || header.stars == 0) return 0;
+
+	if ((size_t)header.rows * header.cols > size) return 0;
+	int cells = header.rows * header.cols;
+	size_t base = sizeof(header) + 2 * (size_t)cells;
+	if (cells == 0 || size < base) return 0;
+
+	const unsigned char* regions = data + sizeof(header);
+	const signed char* board = (const signed char*)(regions + cells);
+
+	// Region ids must be dense, level_build_regions counts on it
+	bool used[SESSION_MAX_REGIONS] = { false };
+	int region_count = 0;
+	for (int i = 0; i < cells; ++i) {
+		used[regions[i]] = true;
+		if (regions[i] + 1 > region_count) region_count = regions[i] + 1;
+		if (board[i] < STARS_GIVEN_EMPTY || board[i] > STARS_GIVEN_QUEEN) return 0;
+	}
+	for (int g = 0; g < region_count; ++g) {
+		if (!used[g]) return 0;
+	}
+
+	_reserve(session, cells);
+	session->header = header;
+	session->cells = cells;
+	memcpy(session->regions, regions, cells);
+	memcpy(session->saved, board, cells);
+
+	// Replay checkpoints, stopping at the first torn or garbled record
+	size_t end = base;
+	int count = 0;
+	while (end + sizeof(uint32_t) <= size) {
+		uint32_t record;
+		memcpy(&record, data + end, sizeof(record));
+		uint32_t cell = record >> 2;
+		int state = (int)(record & 3) - 1;
+		if (cell >= (uint32_t)cells || state > STARS_GIVEN_QUEEN) break;
+
+		session->saved[cell] = (signed char)state;
+		end += sizeof(record);
+		count++;
+	}
+	session->record_count = count;
+	return end;
+}
+
+session_t*
+session_create(const char* path) {
+	session_t* session = (session_t*)mem_calloc(1, sizeof(session_t));
+	assert(session);
+
+	size_t len = strlen(path);
+	session->path = (char*)mem_malloc(len + 1);
+	session->temp_path = (char*)mem_malloc(len + 5);
+	assert(session->path && session->temp_path);
+	memcpy(session->path, path, len + 1);
+	memcpy(session->temp_path, path, len);
+	memcpy(session->temp_path + len, ".tmp", 5);
+
+	return session;
+}
+
+void
+session_destroy(session_t* session) {
+	if (!session) return;
+
+	if (session->log) fclose(session->log);
+	mem_free(session->records);
+	mem_free(session->saved);
+	mem_free(session->regions);
+	mem_free(session->temp_path);
+	mem_free(session->path);
+	mem_free(session);
+}
+
+level_t*
+session_load(session_t* session, const signed char** givens, int* stars, unsigned* seed) {
+	const unsigned char* data;
+	size_t size;
+	void* map;
+	if (!_read_file(session->path, &data, &size, &map)) return NULL;
+
+	size_t intact = _parse(session, data, size);
+	_release_file(map, size);
+	if (intact == 0) return NULL;
+
+	if (session->log) {
+		fclose(session->log);
+		session->log = NULL;
+	}
+	session->active = true;
+
+	// Appending after a torn record would hide everything behind it
+	if (intact != size || session->record_count > session->cells) {
+		_write_base(session);
+	}
+	else {
+		session->log = fopen(session->path, "ab");
+	}
+
+	level_t* level = level_create(session->header.rows, session->header.cols);
+	for (int i = 0; i < session->cells; ++i) {
+		level->regions[i] = session->regions[i];
+	}
+	level_build_regions(level);
+
+	*givens = session->saved;
+	*stars = session->header.stars;
+	*seed = session->header.seed;
+	return level;
+}
+
+bool
+session_begin(session_t* session, const level_t* level, int stars, unsigned seed) {
+	if (!session) return false;
+
+	session->active = level->rows <= UINT16_MAX && level->cols <= UINT16_MAX &&
+		level->region_count <= SESSION_MAX_REGIONS && stars > 0 && stars <= UINT16_MAX;
+	if (!session->active) return false;
+
+	int cells = level->rows * level->cols;
+	_reserve(session, cells);
+
+	session->header.magic = SESSION_MAGIC;
+	session->header.version = SESSION_VERSION;
+	session->header.undo = 0;
+	session->header.rows = (uint16_t)level->rows;
+	session->header.cols = (uint16_t)level->cols;
+	session->header.stars = (uint16_t)stars;
+	session->header.reserved = 0;
+	session->header.seed = seed;
+	session->cells = cells;
+
+	for (int i = 0; i < cells; ++i) {
+		session->regions[i] = (unsigned char)level->regions[i];
+	}
+	memset(session->saved, STARS_GIVEN_NONE, cells);
+
+	return _write_base(session);
+}
+
+bool
+session_checkpoint(session_t* session, const signed char* givens) {
+	if (!session || !session->active || !session->log) return false;
+
+	int count = 0;
+	for (int i = 0; i < session->cells; ++i) {
+		if (givens[i] == session->saved[i]) continue;
+		session->records[count++] = (uint32_t)i << 2 | (uint32_t)(givens[i] + 1);
+		session->saved[i] = givens[i];
+	}
+	if (count == 0) return true;
+
+	// Rewriting is cheaper to load once the records outgrow the board
+	if (session->record_count + count > session->cells) {
+		return _write_base(session);
+	}
+
+	// A short write leaves a torn record, start over from the board
+	if (fwrite(session->records, sizeof(uint32_t), count, session->log) != (size_t)count ||
+		fflush(session->log) != 0) {
+		return _write_base(session);
+	}
+	session->record_count += count;
+	return true;
+}
+
+bool
+session_save(session_t* session, const signed char* givens) {
+	if (!session || !session->active) return false;
+
+	memcpy(session->saved, givens, session->cells);
+	return _write_base(session);
+}
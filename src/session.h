@@ -0,0 +1,100 @@
+#ifndef __SESSION_H
+#define __SESSION_H
+
+#include "level.h"
+
+#include <stdbool.h>
+
+/**********************************************************
+ * Session snapshot
+ *
+ * The level being played and the player's queens and marks,
+ * kept in one file so a relaunch continues where the last
+ * run stopped. Native byte order, fixed layout:
+ *
+ *   header    magic, version, undo position, rows, cols,
+ *             stars, seed
+ *   regions   one byte per cell
+ *   cells     one STARS_GIVEN_* byte per cell
+ *   records   4 bytes each, cell index << 2 | state
+ *
+ * Writing functions accept a NULL session and do nothing.
+ *
+ * Checkpoints only append records for the cells that changed
+ * since the last one. Loading replays them over the cells, a
+ * torn record at the end is ignored. Once the records outgrow
+ * the cells the file is rewritten without them.
+ **********************************************************/
+
+typedef struct session_t session_t;
+
+/**********************************************************
+ * \brief Create a session backed by a file
+ *
+ * Nothing is read or written until the first call below.
+ *
+ * \param path      snapshot file
+ *
+ * \returns newly created session
+ **********************************************************/
+session_t* session_create(const char* path);
+
+/**********************************************************
+ * \brief Close the file and free memory
+ *
+ * \param session   this
+ **********************************************************/
+void session_destroy(session_t* session);
+
+/**********************************************************
+ * \brief Read the snapshot, memory mapped where supported
+ *
+ * Later checkpoints append to the loaded file.
+ *
+ * \param session   this
+ * \param givens    receives the board, one STARS_GIVEN_* per
+ *                  cell, valid until the next session call
+ * \param stars     receives the queens per row, column and region
+ * \param seed      receives the seed the level was generated
+ *                  from, 0 if it was not generated
+ *
+ * \returns newly created level with regions built, NULL if
+ *          there is no valid snapshot
+ **********************************************************/
+level_t* session_load(session_t* session, const signed char** givens, int* stars, unsigned* seed);
+
+/**********************************************************
+ * \brief Start a snapshot of a new level with an empty board
+ *
+ * \param session   this
+ * \param level     level being played
+ * \param stars     queens per row, column and region
+ * \param seed      srand seed that generated it, 0 if none
+ *
+ * \returns false if the file could not be written
+ **********************************************************/
+bool session_begin(session_t* session, const level_t* level, int stars, unsigned seed);
+
+/**********************************************************
+ * \brief Append the cells changed since the last checkpoint
+ *
+ * Does not allocate, cheap enough to call every few seconds.
+ *
+ * \param session   this
+ * \param givens    board as returned by grid_snapshot
+ *
+ * \returns false if the file could not be written
+ **********************************************************/
+bool session_checkpoint(session_t* session, const signed char* givens);
+
+/**********************************************************
+ * \brief Rewrite the whole snapshot without records
+ *
+ * \param session   this
+ * \param givens    board as returned by grid_snapshot
+ *
+ * \returns false if the file could not be written
+ **********************************************************/
+bool session_save(session_t* session, const signed char* givens);
+
+#endif /* __SESSION_H */
@@ -0,0 +1,259 @@
+#include "stars.h"
+#include "mem.h"
+#include "util.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STARS_MAX_ATTEMPTS 1000
+#define STARS_GROUP_TRIES 32
+
+/*
+ * Items: rows, columns and regions are primary with quota `stars`,
+ * every 2x2 window is secondary with quota 1 which forbids touching
+ * queens. One option per cell, added in `order` (cell indices).
+ * `regions` may be NULL to model rows and columns only.
+ */
+static
+dlx_t*
+_build(int rows, int cols, const int* regions, int region_count, int stars, const int* order) {
+	int win_rows = rows > 1 ? rows - 1 : 0;
+	int win_cols = cols > 1 ? cols - 1 : 0;
+	int primary = rows + cols + region_count;
+	int items = primary + win_rows * win_cols;
+	int size = rows * cols;
+
+	dlx_t* dlx = dlx_create(items, primary, size, size * 7);
+	for (int i = 0; i < primary; ++i) {
+		dlx_set_quota(dlx, i, stars);
+	}
+
+	for (int i = 0; i < size; ++i) {
+		int cell = order ? order[i] : i;
+		int r = cell / cols;
+		int c = cell % cols;
+
+		int opt[7];
+		int n = 0;
+		opt[n++] = r;
+		opt[n++] = rows + c;
+		if (regions) {
+			opt[n++] = rows + cols + regions[cell];
+		}
+		for (int wr = r - 1; wr <= r; ++wr) {
+			for (int wc = c - 1; wc <= c; ++wc) {
+				if (wr >= 0 && wc >= 0 && wr < win_rows && wc < win_cols) {
+					opt[n++] = primary + wr * win_cols + wc;
+				}
+			}
+		}
+		dlx_add_option(dlx, opt, n);
+	}
+
+	return dlx;
+}
+
+static
+int
+_solve(const level_t* level, int stars, const signed char* givens,
+		int limit, int* queens, dlx_stop_fn stop, void* user, long long* nodes) {
+	int size = level->rows * level->cols;
+	dlx_t* dlx = _build(level->rows, level->cols, level->regions, level->region_count, stars, NULL);
+	dlx_set_stop(dlx, stop, user);
+
+	int found = 0;
+	bool feasible = true;
+	if (givens) {
+		for (int i = 0; i < size && feasible; ++i) {
+			if (givens[i] == STARS_GIVEN_QUEEN) {
+				feasible = dlx_select(dlx, i);
+			}
+		}
+		for (int i = 0; i < size && feasible; ++i) {
+			if (givens[i] == STARS_GIVEN_EMPTY) {
+				dlx_exclude(dlx, i);
+			}
+		}
+	}
+
+	if (feasible) {
+		// Option ids are cell indices since _build added them in order
+		found = dlx_solve(dlx, limit, queens, NULL);
+	}
+
+	if (nodes) *nodes = dlx_nodes(dlx);
+	dlx_destroy(dlx);
+	return found;
+}
+
+int
+stars_solve(const level_t* level, int stars, const signed char* givens,
+		int limit, int* queens, dlx_stop_fn stop, void* user) {
+	return _solve(level, stars, givens, limit, queens, stop, user, NULL);
+}
+
+int
+stars_count(const level_t* level, int stars, int limit, long long* nodes) {
+	return _solve(level, stars, NULL, limit, NULL, NULL, NULL, nodes);
+}
+
+/*
+ * Grow one seed region per queen, then glue the seed regions into
+ * connected groups of `stars`. Fails if the greedy grouping gets stuck.
+ */
+static
+bool
+_group_regions(int rows, int cols, int stars, const int* queens, int* regions, unsigned* rng) {
+	int size = rows * cols;
+	int seeds = rows * stars;
+
+	int* seed = (int*)mem_malloc(size * sizeof(int));
+	int* frontier = (int*)mem_malloc(size * sizeof(int));
+	unsigned char* touch = (unsigned char*)mem_calloc(seeds * seeds, 1);
+	int* group = (int*)mem_malloc(seeds * sizeof(int));
+	int* members = (int*)mem_malloc(stars * sizeof(int));
+	assert(seed && frontier && touch && group && members);
+
+	for (int i = 0; i < size; ++i) {
+		seed[i] = -1;
+	}
+	int back = 0;
+	for (int i = 0; i < seeds; ++i) {
+		seed[queens[i]] = i;
+		frontier[back++] = queens[i];
+	}
+
+	// Random-order flood fill for irregular shapes
+	int d[5] = { -1, 0, 1, 0, -1 };
+	while (back > 0) {
+		int k = util_rand(rng) % back;
+		int idx = frontier[k];
+		frontier[k] = frontier[--back];
+
+		int r = idx / cols;
+		int c = idx % cols;
+		for (int i = 0; i < 4; ++i) {
+			int nr = r + d[i];
+			int nc = c + d[i + 1];
+			if (nr < 0 || nc < 0 || nr >= rows || nc >= cols)
+				continue;
+
+			int nidx = nr * cols + nc;
+			if (seed[nidx] == -1) {
+				seed[nidx] = seed[idx];
+				frontier[back++] = nidx;
+			}
+			else if (seed[nidx] != seed[idx]) {
+				touch[seed[idx] * seeds + seed[nidx]] = 1;
+				touch[seed[nidx] * seeds + seed[idx]] = 1;
+			}
+		}
+	}
+
+	for (int i = 0; i < seeds; ++i) {
+		group[i] = -1;
+	}
+
+	bool ok = true;
+	for (int g = 0; g < rows && ok; ++g) {
+		// Start from the ungrouped seed with the fewest free neighbours
+		int start = -1;
+		int start_free = 0;
+		for (int i = 0; i < seeds; ++i) {
+			if (group[i] != -1) continue;
+			int free_count = 0;
+			for (int j = 0; j < seeds; ++j) {
+				if (group[j] == -1 && touch[i * seeds + j]) free_count++;
+			}
+			if (start == -1 || free_count < start_free) {
+				start = i;
+				start_free = free_count;
+			}
+		}
+
+		group[start] = g;
+		members[0] = start;
+		int count = 1;
+
+		while (count < stars) {
+			int pick = -1;
+			int seen = 0;
+			for (int m = 0; m < count; ++m) {
+				for (int j = 0; j < seeds; ++j) {
+					if (group[j] == -1 && touch[members[m] * seeds + j]) {
+						// Reservoir sample a random free neighbour
+						if (util_rand(rng) % ++seen == 0) pick = j;
+					}
+				}
+			}
+			if (pick == -1) {
+				ok = false;
+				break;
+			}
+			group[pick] = g;
+			members[count++] = pick;
+		}
+	}
+
+	if (ok) {
+		for (int i = 0; i < size; ++i) {
+			regions[i] = group[seed[i]];
+		}
+	}
+
+	mem_free(members);
+	mem_free(group);
+	mem_free(touch);
+	mem_free(frontier);
+	mem_free(seed);
+	return ok;
+}
+
+level_t*
+stars_generate(int size, int stars, bool unique, unsigned* rng) {
+	assert(size > 0 && stars > 0);
+
+	int cells = size * size;
+	int* order = (int*)mem_malloc(cells * sizeof(int));
+	int* queens = (int*)mem_malloc(cells * sizeof(int));
+	assert(order && queens);
+
+	level_t* level = level_create(size, size);
+	bool done = false;
+
+	for (int attempt = 0; attempt < STARS_MAX_ATTEMPTS && !done; ++attempt) {
+		// Random solution first, so every candidate is solvable
+		for (int i = 0; i < cells; ++i) {
+			order[i] = i;
+		}
+		util_shuffle(order, cells, rng);
+
+		dlx_t* dlx = _build(size, size, NULL, 0, stars, order);
+		int count = 0;
+		int found = dlx_solve(dlx, 1, queens, &count);
+		dlx_destroy(dlx);
+		if (found < 1) break;
+
+		for (int i = 0; i < count; ++i) {
+			queens[i] = order[queens[i]];
+		}
+
+		for (int t = 0; t < STARS_GROUP_TRIES && !done; ++t) {
+			if (!_group_regions(size, size, stars, queens, level->regions, rng)) continue;
+			level->region_count = size; // all stars_solve needs, the rest is built once at the end
+			done = !unique || stars_solve(level, stars, NULL, 2, NULL, NULL, NULL) == 1;
+		}
+	}
+
+	mem_free(queens);
+	mem_free(order);
+
+	if (!done) {
+		level_destroy(level);
+		return NULL;
+	}
+
+	level_build_regions(level);
+	return level;
+}
@@ -0,0 +1,60 @@
+#ifndef __STARS_H
+#define __STARS_H
+
+#include "level.h"
+#include "dlx.h"
+
+#include <stdbool.h>
+
+/**********************************************************
+ * k-queens-per-region ("k-star") rules on top of the exact
+ * cover engine. Every row, column and region holds exactly
+ * `stars` queens and no two queens touch, diagonals included.
+ **********************************************************/
+
+#define STARS_GIVEN_NONE 0
+#define STARS_GIVEN_QUEEN 1
+#define STARS_GIVEN_EMPTY -1
+
+/**********************************************************
+ * \brief Solve a level under k-star rules
+ *
+ * \param level     level to solve, region_count must be set
+ * \param stars     queens per row, column and region
+ * \param givens    optional, one STARS_GIVEN_* per cell
+ * \param limit     stop after this many solutions
+ * \param queens    optional, receives the cell index of each
+ *                  queen of the first solution (rows * stars)
+ * \param stop      optional callback polled to abort search
+ * \param user      passed to stop
+ *
+ * \returns number of solutions found up to limit, -1 if stopped
+ **********************************************************/
+int stars_solve(const level_t* level, int stars, const signed char* givens,
+		int limit, int* queens, dlx_stop_fn stop, void* user);
+
+/**********************************************************
+ * \brief Count solutions of an empty board
+ *
+ * \param level     level to solve
+ * \param stars     queens per row, column and region
+ * \param limit     stop after this many solutions
+ * \param nodes     receives the search nodes visited
+ *
+ * \returns number of solutions found up to limit
+ **********************************************************/
+int stars_count(const level_t* level, int stars, int limit, long long* nodes);
+
+/**********************************************************
+ * \brief Generate a square level under k-star rules
+ *
+ * \param size      rows, columns and region count
+ * \param stars     queens per row, column and region
+ * \param unique    require exactly one solution
+ * \param rng       util_rand state, NULL to use rand()
+ *
+ * \returns newly created level, NULL if none was found
+ **********************************************************/
+level_t* stars_generate(int size, int stars, bool unique, unsigned* rng);
+
+#endif /* __STARS_H */
@@ -0,0 +1,46 @@
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "util.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+double
+util_now_ms(void) {
+	struct timespec ts;
+#if defined(__unix__) || defined(__APPLE__)
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+	timespec_get(&ts, TIME_UTC);
+#endif
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int
+util_rand(unsigned* rng) {
+	if (!rng) return rand();
+
+	// xorshift32, never leaves zero so start elsewhere
+	uint32_t x = *rng ? (uint32_t)*rng : 0x9e3779b9u;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*rng = x;
+	return (int)(x >> 1);
+}
+
+void
+util_shuffle(int* arr, int n, unsigned* rng) {
+	if (!arr || n <= 1) return;
+
+	for (int i = n - 1; i > 0; --i) {
+		int j = util_rand(rng) % (i + 1); // random index from 0 to i
+
+		int tmp = arr[i];
+		arr[i] = arr[j];
+		arr[j] = tmp;
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef __UTIL_H
+#define __UTIL_H
+
+/**********************************************************
+ * Small helpers shared by the game and the tools
+ **********************************************************/
+
+/**********************************************************
+ * \brief Read a millisecond clock for timing work
+ *
+ * Monotonic where the platform has one, only differences
+ * between two calls are meaningful.
+ *
+ * \returns milliseconds
+ **********************************************************/
+double util_now_ms(void);
+
+/**********************************************************
+ * \brief Draw a random number
+ *
+ * Generators running on several threads each keep their own
+ * state, rand() shares one and is not required to be thread
+ * safe. A zero state is replaced by a fixed non-zero one.
+ *
+ * \param rng       xorshift state, NULL to use rand()
+ *
+ * \returns value from 0 to at least RAND_MAX
+ **********************************************************/
+int util_rand(unsigned* rng);
+
+/**********************************************************
+ * \brief Shuffle an array in place, Fisher-Yates
+ *
+ * \param arr       values to shuffle
+ * \param n         number of values
+ * \param rng       xorshift state, NULL to use rand()
+ **********************************************************/
+void util_shuffle(int* arr, int n, unsigned* rng);
+
+#endif /* __UTIL_H */
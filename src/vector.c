@@ -1,4 +1,5 @@
 #include "vector.h"
+#include "mem.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -15,12 +16,12 @@ struct vector_t {
 
 vector_t*
 vector_new(void) {
-    vector_t* vector = malloc(sizeof(vector_t));
+    vector_t* vector = mem_malloc(sizeof(vector_t));
     assert(vector);
 
     vector->capacity = VECTOR_INIT_CAPACITY;
     vector->total = 0;
-    vector->items = malloc(sizeof(void*) * vector->capacity);
+    vector->items = mem_malloc(sizeof(void*) * vector->capacity);
     assert(vector->items);
 
     return vector;
@@ -28,12 +29,12 @@ vector_new(void) {
 
 vector_t*
 vector_new_size(int size) {
-    vector_t* vector = malloc(sizeof(vector_t));
+    vector_t* vector = mem_malloc(sizeof(vector_t));
     assert(vector);
 
     vector->capacity = size;
     vector->total = 0;
-    vector->items = malloc(sizeof(void*) * vector->capacity);
+    vector->items = mem_malloc(sizeof(void*) * vector->capacity);
     assert(vector->items);
 
     return vector;
@@ -43,8 +44,8 @@ void
 vector_destroy(vector_t* vector) {
     assert(vector);
 
-    free(vector->items);
-    free(vector);
+    mem_free(vector->items);
+    mem_free(vector);
 }
 
 int
@@ -71,7 +72,7 @@ vector_shuffle(vector_t* vector) {
 static
 void
 vector_resize(vector_t* vector, int capacity) {
-    void** items = realloc(vector->items, sizeof(void*) * capacity);
+    void** items = mem_realloc(vector->items, sizeof(void*) * capacity);
     assert(items);
 
     vector->items = items;
@@ -108,7 +109,7 @@ vector_pushback(vector_t* vector, void* item, int size) {
         vector_resize(vector, vector->capacity * 2);
     }
 
-    void* item_ptr = malloc(sizeof(size));
+    void* item_ptr = mem_malloc(size);
     assert(item_ptr);
     memcpy(item_ptr, item, size);
 
@@ -117,7 +118,14 @@ vector_pushback(vector_t* vector, void* item, int size) {
 
 void 
 vector_popback(vector_t* vector) {
-    vector_delete(vector, vector->total);
+    assert(vector);
+    if (vector->total == 0) {
+        return;
+    }
+
+    // Items added with vector_pushback are owned copies
+    mem_free(vector->items[vector->total - 1]);
+    vector_delete(vector, vector->total - 1);
 }
 
 void
@@ -0,0 +1,139 @@
+#include "level.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIST_BUCKETS 32
+
+/* Power of two histogram, bucket i holds values in [2^(i-1), 2^i) */
+typedef struct {
+	long long buckets[HIST_BUCKETS];
+} histogram_t;
+
+typedef struct {
+	int levels;
+	int failed; // no queen placement, e.g. sizes 2 and 3, not in the stats
+	histogram_t nodes;
+	histogram_t backtracks;
+	histogram_t total_us;
+	long long sum_nodes;
+	long long sum_backtracks;
+	long long sum_flood_cells;
+	double sum_placement_ms;
+	double sum_flood_ms;
+	double sum_regions_ms;
+	double sum_total_ms;
+	int max_depth;
+	long long worst_nodes;
+	unsigned worst_seed;
+} batch_stats_t;
+
+static
+void
+hist_add(histogram_t* hist, long long value) {
+	int bucket = 0;
+	while (value > 0 && bucket < HIST_BUCKETS - 1) {
+		value >>= 1;
+		bucket++;
+	}
+	hist->buckets[bucket]++;
+}
+
+static
+void
+hist_print(const char* name, const histogram_t* hist) {
+	int last = 0;
+	for (int i = 0; i < HIST_BUCKETS; ++i) {
+		if (hist->buckets[i]) last = i;
+	}
+
+	printf("  %s\n", name);
+	for (int i = 0; i <= last; ++i) {
+		long long lo = i == 0 ? 0 : 1ll << (i - 1);
+		long long hi = (1ll << i) - 1;
+		printf("    %10lld - %-10lld %lld\n", lo, hi, hist->buckets[i]);
+	}
+}
+
+static
+void
+batch_add(batch_stats_t* batch, const level_stats_t* stats, unsigned seed) {
+	batch->levels++;
+	hist_add(&batch->nodes, stats->placement_nodes);
+	hist_add(&batch->backtracks, stats->backtracks);
+	hist_add(&batch->total_us, (long long)(stats->total_ms * 1000.0));
+
+	batch->sum_nodes += stats->placement_nodes;
+	batch->sum_backtracks += stats->backtracks;
+	batch->sum_flood_cells += stats->flood_cells;
+	batch->sum_placement_ms += stats->placement_ms;
+	batch->sum_flood_ms += stats->flood_ms;
+	batch->sum_regions_ms += stats->regions_ms;
+	batch->sum_total_ms += stats->total_ms;
+
+	if (stats->max_depth > batch->max_depth) {
+		batch->max_depth = stats->max_depth;
+	}
+	if (stats->placement_nodes > batch->worst_nodes) {
+		batch->worst_nodes = stats->placement_nodes;
+		batch->worst_seed = seed;
+	}
+}
+
+static
+void
+batch_print(int size, const batch_stats_t* batch) {
+	double n = batch->levels;
+
+	printf("size %d: %d levels, %d failed\n", size, batch->levels, batch->failed);
+	if (batch->levels == 0) return;
+
+	printf("  mean nodes %.1f, backtracks %.1f, flood cells %.1f, max depth %d\n",
+		batch->sum_nodes / n, batch->sum_backtracks / n, batch->sum_flood_cells / n, batch->max_depth);
+	printf("  mean ms placement %.4f, flood %.4f, regions %.4f, total %.4f\n",
+		batch->sum_placement_ms / n, batch->sum_flood_ms / n, batch->sum_regions_ms / n, batch->sum_total_ms / n);
+	printf("  worst seed %u with %lld nodes\n", batch->worst_seed, batch->worst_nodes);
+
+	hist_print("placement nodes", &batch->nodes);
+	hist_print("backtracks", &batch->backtracks);
+	hist_print("total us", &batch->total_us);
+}
+
+int
+main(int argc, char* argv[]) {
+	if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+		printf("usage: %s [min_size] [max_size] [count] [seed]\n", argv[0]);
+		return 0;
+	}
+
+	int min_size = argc > 1 ? atoi(argv[1]) : 5;
+	int max_size = argc > 2 ? atoi(argv[2]) : 10;
+	int count = argc > 3 ? atoi(argv[3]) : 1000;
+	unsigned seed = argc > 4 ? (unsigned)strtoul(argv[4], NULL, 10) : 1u;
+
+	for (int size = min_size; size <= max_size; ++size) {
+		batch_stats_t batch;
+		memset(&batch, 0, sizeof(batch));
+
+		for (int i = 0; i < count; ++i) {
+			// One seed per level so a pathological one can be replayed
+			unsigned level_seed = seed + (unsigned)i;
+			srand(level_seed);
+
+			level_stats_t stats;
+			level_t* level = level_generate(size, size, NULL, &stats);
+			if (!level) {
+				batch.failed++;
+				continue;
+			}
+			level_destroy(level);
+
+			batch_add(&batch, &stats, level_seed);
+		}
+
+		batch_print(size, &batch);
+	}
+
+	return 0;
+}
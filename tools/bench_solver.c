@@ -0,0 +1,170 @@
+#include "level.h"
+#include "stars.h"
+#include "util.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LEVELS_PER_SIZE 20
+#define SOLUTION_LIMIT 2
+
+/*
+ * Row-by-row backtracker in the style of place_row, extended with
+ * region and k-per-line quotas. Used as the baseline.
+ */
+typedef struct {
+	int n;
+	int stars;
+	const int* regions;
+	int* col_count;
+	int* region_count;
+	unsigned char* queen;
+	int found;
+	int limit;
+	long long nodes;
+} backtracker_t;
+
+static
+bool
+bt_touches(const backtracker_t* bt, int row, int col) {
+	for (int dc = -1; dc <= 1; ++dc) {
+		int c = col + dc;
+		if (c < 0 || c >= bt->n) continue;
+		if (row > 0 && bt->queen[(row - 1) * bt->n + c]) return true;
+		if (bt->queen[row * bt->n + c]) return true;
+	}
+	return false;
+}
+
+static
+void
+bt_row(backtracker_t* bt, int row, int start, int placed) {
+	bt->nodes++;
+	if (bt->found >= bt->limit) return;
+
+	if (placed == bt->stars) {
+		if (row + 1 == bt->n) {
+			bt->found++;
+			return;
+		}
+		bt_row(bt, row + 1, 0, 0);
+		return;
+	}
+
+	for (int col = start; col < bt->n; ++col) {
+		int idx = row * bt->n + col;
+		int region = bt->regions[idx];
+
+		if (bt->col_count[col] >= bt->stars) continue;
+		if (bt->region_count[region] >= bt->stars) continue;
+		if (bt_touches(bt, row, col)) continue;
+
+		bt->queen[idx] = 1;
+		bt->col_count[col]++;
+		bt->region_count[region]++;
+
+		bt_row(bt, row, col + 2, placed + 1);
+
+		bt->region_count[region]--;
+		bt->col_count[col]--;
+		bt->queen[idx] = 0;
+
+		if (bt->found >= bt->limit) return;
+	}
+}
+
+static
+int
+bt_solve(const level_t* level, int stars, int limit, long long* nodes) {
+	int n = level->rows;
+	backtracker_t bt = { 0 };
+	bt.n = n;
+	bt.stars = stars;
+	bt.regions = level->regions;
+	bt.col_count = (int*)calloc(n, sizeof(int));
+	bt.region_count = (int*)calloc(n * n, sizeof(int));
+	bt.queen = (unsigned char*)calloc(n * n, 1);
+	bt.limit = limit;
+	assert(bt.col_count && bt.region_count && bt.queen);
+
+	bt_row(&bt, 0, 0, 0);
+
+	free(bt.queen);
+	free(bt.region_count);
+	free(bt.col_count);
+	*nodes = bt.nodes;
+	return bt.found;
+}
+
+static
+void
+bench_size(int size, int stars) {
+	level_t* levels[LEVELS_PER_SIZE];
+	int count = 0;
+
+	for (int i = 0; i < LEVELS_PER_SIZE; ++i) {
+		level_t* level = stars == 1 ? level_generate(size, size, NULL, NULL) : stars_generate(size, stars, false, NULL);
+		if (level) levels[count++] = level;
+	}
+	if (count == 0) {
+		printf("%5d %5d %8s\n", size, stars, "-");
+		return;
+	}
+
+	long long bt_nodes = 0;
+	double start = util_now_ms();
+	int bt_found = 0;
+	for (int i = 0; i < count; ++i) {
+		long long nodes = 0;
+		bt_found += bt_solve(levels[i], stars, SOLUTION_LIMIT, &nodes);
+		bt_nodes += nodes;
+	}
+	double bt_ms = util_now_ms() - start;
+
+	long long dlx_node_count = 0;
+	start = util_now_ms();
+	int dlx_found = 0;
+	for (int i = 0; i < count; ++i) {
+		long long nodes = 0;
+		dlx_found += stars_count(levels[i], stars, SOLUTION_LIMIT, &nodes);
+		dlx_node_count += nodes;
+	}
+	double dlx_ms = util_now_ms() - start;
+
+	if (bt_found != dlx_found) {
+		fprintf(stderr, "solution count mismatch at size %d: %d vs %d\n", size, bt_found, dlx_found);
+	}
+
+	printf("%5d %5d %8d %12.3f %12lld %12.3f %12lld %8.2fx\n",
+		size, stars, count,
+		bt_ms / count, bt_nodes / count,
+		dlx_ms / count, dlx_node_count / count,
+		dlx_ms > 0.0 ? bt_ms / dlx_ms : 0.0);
+
+	for (int i = 0; i < count; ++i) {
+		level_destroy(levels[i]);
+	}
+}
+
+int
+main(int argc, char* argv[]) {
+	int max_size = argc > 1 ? atoi(argv[1]) : 12;
+	srand(argc > 2 ? (unsigned)atoi(argv[2]) : 1u);
+
+	printf("%5s %5s %8s %12s %12s %12s %12s %9s\n",
+		"size", "stars", "levels", "bt ms", "bt nodes", "dlx ms", "dlx nodes", "speedup");
+
+	for (int size = 5; size <= max_size; ++size) {
+		bench_size(size, 1);
+	}
+	for (int size = 8; size <= max_size; ++size) {
+		bench_size(size, 2);
+	}
+	for (int size = 11; size <= max_size; ++size) {
+		bench_size(size, 3);
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "level_io.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int
+main(int argc, char* argv[]) {
+	if (argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+		printf("usage: %s <input|-> [output]\n", argv[0]);
+		printf("Validates a level file and optionally writes it back normalised.\n");
+		return argc < 2 ? 1 : 0;
+	}
+
+	level_reader_t* reader = strcmp(argv[1], "-") == 0
+		? level_reader_open_stream(stdin)
+		: level_reader_open(argv[1]);
+	if (!reader) {
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	FILE* out = NULL;
+	if (argc > 2) {
+		out = strcmp(argv[2], "-") == 0 ? stdout : fopen(argv[2], "wb");
+		if (!out) {
+			fprintf(stderr, "cannot open %s\n", argv[2]);
+			level_reader_close(reader);
+			return 1;
+		}
+	}
+
+	long long valid = 0;
+	long long invalid = 0;
+	double start = util_now_ms();
+
+	for (;;) {
+		level_meta_t meta;
+		const level_t* level = level_reader_next(reader, &meta);
+		if (!level) {
+			const char* error = level_reader_error(reader);
+			if (!error) break;
+
+			fprintf(stderr, "%s: %s\n", argv[1], error);
+			invalid++;
+			continue;
+		}
+
+		valid++;
+		if (out && !level_write(out, level, &meta)) {
+			fprintf(stderr, "write failed\n");
+			break;
+		}
+	}
+
+	double elapsed = util_now_ms() - start;
+	fprintf(stderr, "%lld valid, %lld invalid in %.1f ms (%.0f puzzles/s)\n",
+		valid, invalid, elapsed, elapsed > 0.0 ? (valid + invalid) * 1000.0 / elapsed : 0.0);
+
+	if (out && out != stdout) fclose(out);
+	level_reader_close(reader);
+	return invalid > 0 ? 2 : 0;
+}
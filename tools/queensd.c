@@ -0,0 +1,541 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "level.h"
+#include "level_client.h"
+#include "stars.h"
+#include "util.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_POOLS 32
+#define MAX_GENERATORS 64
+
+// A pool whose generator keeps failing is skipped for a while, so it
+// cannot hold every thread while the other pools run dry
+#define BACKOFF_FAILURES 16
+#define BACKOFF_MIN_MS 100.0
+#define BACKOFF_MAX_MS 5000.0
+
+/*
+ * Level server. Background generators keep one pool per board size
+ * and star count topped up with levels checked by the solver; a single
+ * poll() loop answers requests straight from the pools. The request
+ * path never generates, a drained pool answers LEVEL_PROTO_EMPTY at
+ * once and the client falls back to generating locally.
+ *
+ * Pool slots hold ready encoded responses, so serving one is a copy.
+ */
+
+typedef struct {
+	int size;
+	int stars;
+	int capacity;
+	int head;
+	int count;
+	int slot_size;
+	unsigned char* slots;
+	long long generated;
+	long long rejected;
+	long long served;
+	long long empty;
+	int failures;      // rejections in a row
+	double backoff_ms; // current pause, doubles while failing
+	double retry_at;   // util_now_ms() when the pool may be picked again
+} pool_t;
+
+typedef struct {
+	int fd;
+	unsigned char in[sizeof(level_request_t)];
+	int in_len;
+	unsigned char out[sizeof(level_response_t) + LEVEL_PROTO_MAX_SIZE * LEVEL_PROTO_MAX_SIZE];
+	int out_len;
+	int out_off;
+} client_t;
+
+typedef struct {
+	pool_t pools[MAX_POOLS];
+	int pool_count;
+	bool unique;
+
+	// Guards the pools, generators sleep on space while all are full
+	pthread_mutex_t lock;
+	pthread_cond_t space;
+	bool quit;
+	unsigned seed;      // next generator's util_rand state
+
+	client_t* clients;
+	struct pollfd* fds; // fds[0] is the listening socket, fds[i + 1] is clients[i]
+	int client_count;
+	int max_clients;
+	long long requests;
+	long long bad_requests;
+} server_t;
+
+static volatile sig_atomic_t stopping = 0;
+
+static
+void
+on_signal(int sig) {
+	(void)sig;
+	stopping = 1;
+}
+
+static
+pool_t*
+find_pool(server_t* server, int size, int stars) {
+	for (int i = 0; i < server->pool_count; ++i) {
+		if (server->pools[i].size == size && server->pools[i].stars == stars) {
+			return &server->pools[i];
+		}
+	}
+	return NULL;
+}
+
+// Emptiest pool first, so every size fills at the same pace. Pools
+// backing off are skipped, next_retry receives the earliest end of a
+// backoff or 0 if none is pending
+static
+pool_t*
+neediest_pool(server_t* server, double now, double* next_retry) {
+	pool_t* best = NULL;
+	*next_retry = 0.0;
+	for (int i = 0; i < server->pool_count; ++i) {
+		pool_t* pool = &server->pools[i];
+		if (pool->count == pool->capacity) continue;
+		if (pool->retry_at > now) {
+			if (*next_retry == 0.0 || pool->retry_at < *next_retry) *next_retry = pool->retry_at;
+			continue;
+		}
+		if (!best || (long long)pool->count * best->capacity < (long long)best->count * pool->capacity) {
+			best = pool;
+		}
+	}
+	return best;
+}
+
+static
+level_t*
+generate(int size, int stars, bool unique, unsigned* rng) {
+	// The plain generator is much faster, but neither guarantees a
+	// unique solution nor knows about more than one star
+	level_t* level = stars == 1 && !unique
+		? level_generate(size, size, rng, NULL)
+		: stars_generate(size, stars, unique, rng);
+	if (!level) return NULL;
+
+	int found = stars_solve(level, stars, NULL, unique ? 2 : 1, NULL, NULL, NULL);
+	if (unique ? found != 1 : found < 1) {
+		level_destroy(level);
+		return NULL;
+	}
+	return level;
+}
+
+static
+void*
+generator(void* data) {
+	server_t* server = (server_t*)data;
+
+	// rand() shares one state between all threads, each generator
+	// draws from its own, spaced apart so no two start alike
+	pthread_mutex_lock(&server->lock);
+	unsigned rng = server->seed;
+	server->seed += 0x9e3779b9u;
+	for (;;) {
+		pool_t* pool = NULL;
+		while (!server->quit) {
+			double next_retry;
+			double now = util_now_ms();
+			pool = neediest_pool(server, now, &next_retry);
+			if (pool) break;
+
+			if (next_retry == 0.0) {
+				pthread_cond_wait(&server->space, &server->lock);
+				continue;
+			}
+
+			// The condition waits on the wall clock, util_now_ms is monotonic
+			struct timespec until;
+			clock_gettime(CLOCK_REALTIME, &until);
+			long long ns = until.tv_nsec + (long long)((next_retry - now) * 1000000.0);
+			until.tv_sec += (time_t)(ns / 1000000000);
+			until.tv_nsec = (long)(ns % 1000000000);
+			pthread_cond_timedwait(&server->space, &server->lock, &until);
+		}
+		if (server->quit) break;
+
+		int size = pool->size;
+		int stars = pool->stars;
+		pthread_mutex_unlock(&server->lock);
+
+		level_t* level = generate(size, stars, server->unique, &rng);
+
+		pthread_mutex_lock(&server->lock);
+		if (!level) {
+			pool->rejected++;
+			if (++pool->failures >= BACKOFF_FAILURES) {
+				pool->failures = 0;
+				pool->backoff_ms = pool->backoff_ms == 0.0 ? BACKOFF_MIN_MS : pool->backoff_ms * 2.0;
+				if (pool->backoff_ms > BACKOFF_MAX_MS) pool->backoff_ms = BACKOFF_MAX_MS;
+				pool->retry_at = util_now_ms() + pool->backoff_ms;
+			}
+			continue;
+		}
+		pool->failures = 0;
+		pool->backoff_ms = 0.0;
+		if (pool->count < pool->capacity) {
+			int slot = (pool->head + pool->count) % pool->capacity;
+			unsigned char* out = pool->slots + slot * pool->slot_size;
+			level_response_t header = {
+				LEVEL_PROTO_MAGIC, LEVEL_PROTO_OK, (uint8_t)size, (uint8_t)size, (uint8_t)stars
+			};
+			memcpy(out, &header, sizeof(header));
+			for (int i = 0; i < size * size; ++i) {
+				out[sizeof(header) + i] = (unsigned char)level->regions[i];
+			}
+			pool->count++;
+			pool->generated++;
+		}
+		level_destroy(level);
+	}
+	pthread_mutex_unlock(&server->lock);
+
+	return NULL;
+}
+
+static
+void
+answer(server_t* server, client_t* client) {
+	level_request_t request;
+	memcpy(&request, client->in, sizeof(request));
+	client->in_len = 0;
+	client->out_off = 0;
+	server->requests++;
+
+	level_response_t header = { LEVEL_PROTO_MAGIC, LEVEL_PROTO_OK, request.rows, request.cols, request.stars };
+
+	if (request.magic != LEVEL_PROTO_MAGIC || request.rows != request.cols) {
+		header.status = LEVEL_PROTO_BAD_REQUEST;
+		server->bad_requests++;
+	}
+	else {
+		pthread_mutex_lock(&server->lock);
+		pool_t* pool = find_pool(server, request.rows, request.stars);
+		if (!pool) {
+			header.status = LEVEL_PROTO_UNSUPPORTED;
+		}
+		else if (pool->count == 0) {
+			header.status = LEVEL_PROTO_EMPTY;
+			pool->empty++;
+		}
+		else {
+			memcpy(client->out, pool->slots + pool->head * pool->slot_size, pool->slot_size);
+			client->out_len = pool->slot_size;
+			pool->head = (pool->head + 1) % pool->capacity;
+			pool->count--;
+			pool->served++;
+			pthread_cond_signal(&server->space);
+		}
+		pthread_mutex_unlock(&server->lock);
+
+		if (header.status == LEVEL_PROTO_OK) return;
+	}
+
+	memcpy(client->out, &header, sizeof(header));
+	client->out_len = sizeof(header);
+}
+
+static
+void
+drop_client(server_t* server, int index) {
+	close(server->clients[index].fd);
+	server->client_count--;
+	server->clients[index] = server->clients[server->client_count];
+	server->fds[index + 1] = server->fds[server->client_count + 1];
+}
+
+// Returns false if the client hung up or broke the protocol
+static
+bool
+serve_client(server_t* server, client_t* client, short revents) {
+	if (revents & (POLLERR | POLLNVAL)) return false;
+
+	for (;;) {
+		// Flush the previous answer before reading the next request
+		while (client->out_off < client->out_len) {
+			ssize_t n = send(client->fd, client->out + client->out_off,
+				client->out_len - client->out_off, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR) continue;
+			if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+			if (n <= 0) return false;
+			client->out_off += (int)n;
+		}
+		client->out_len = client->out_off = 0;
+
+		ssize_t n = recv(client->fd, client->in + client->in_len,
+			sizeof(client->in) - client->in_len, 0);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+		if (n <= 0) return false;
+
+		client->in_len += (int)n;
+		if (client->in_len == (int)sizeof(client->in)) {
+			answer(server, client);
+		}
+	}
+}
+
+static
+void
+accept_clients(server_t* server, int listener) {
+	for (;;) {
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR) continue;
+			return; // EAGAIN, or out of descriptors until someone leaves
+		}
+
+		if (server->client_count == server->max_clients) {
+			close(fd);
+			continue;
+		}
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+		client_t* client = &server->clients[server->client_count];
+		memset(client, 0, sizeof(*client));
+		client->fd = fd;
+		server->fds[server->client_count + 1] = (struct pollfd){ fd, POLLIN, 0 };
+		server->client_count++;
+	}
+}
+
+static
+int
+open_listener(const char* path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "socket path too long: %s\n", path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	unlink(path); // stale socket left by a previous run
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+		fprintf(stderr, "cannot listen on %s: %s\n", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+// Whether `stars` queens fit in every row and column without touching,
+// regions aside. One region per row leaves just those constraints
+static
+bool
+has_placement(int size, int stars) {
+	level_t* level = level_create(size, size);
+	for (int i = 0; i < size * size; ++i) {
+		level->regions[i] = i / size;
+	}
+	level_build_regions(level);
+
+	long long nodes;
+	bool found = stars_count(level, stars, 1, &nodes) > 0;
+	level_destroy(level);
+	return found;
+}
+
+static
+bool
+add_pool(server_t* server, const char* spec, int capacity) {
+	int size = 0;
+	int stars = 1;
+	if (sscanf(spec, "%d:%d", &size, &stars) < 1 ||
+		size < 1 || size > LEVEL_PROTO_MAX_SIZE || stars < 1 || stars > 255) {
+		fprintf(stderr, "invalid pool %s, expected SIZE or SIZE:STARS up to %d\n", spec, LEVEL_PROTO_MAX_SIZE);
+		return false;
+	}
+	if (find_pool(server, size, stars)) return true;
+	if (!has_placement(size, stars)) {
+		fprintf(stderr, "invalid pool %s, no %d-star level of size %d exists\n", spec, stars, size);
+		return false;
+	}
+	if (server->pool_count == MAX_POOLS) {
+		fprintf(stderr, "at most %d pools\n", MAX_POOLS);
+		return false;
+	}
+
+	pool_t* pool = &server->pools[server->pool_count++];
+	pool->size = size;
+	pool->stars = stars;
+	pool->capacity = capacity;
+	pool->slot_size = (int)sizeof(level_response_t) + size * size;
+	pool->slots = (unsigned char*)malloc((size_t)capacity * pool->slot_size);
+	if (!pool->slots) {
+		fprintf(stderr, "out of memory\n");
+		return false;
+	}
+	return true;
+}
+
+static
+void
+usage(const char* name) {
+	printf("usage: %s [-s socket] [-j generators] [-p pool_size] [-c max_clients] [-u] [SIZE[:STARS]...]\n", name);
+	printf("  default pools are sizes 5 to 10 with one star, -u only serves unique levels\n");
+}
+
+int
+main(int argc, char* argv[]) {
+	const char* path = getenv(LEVEL_PROTO_SOCKET_ENV);
+	if (!path || !*path) path = LEVEL_PROTO_DEFAULT_SOCKET;
+	int generators = 2;
+	int capacity = 256;
+
+	static server_t server;
+	server.max_clients = 1024;
+
+	int first_pool = argc;
+	for (int i = 1; i < argc; ++i) {
+		bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "-s") == 0 && has_value) path = argv[++i];
+		else if (strcmp(argv[i], "-j") == 0 && has_value) generators = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-p") == 0 && has_value) capacity = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c") == 0 && has_value) server.max_clients = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-u") == 0) server.unique = true;
+		else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		}
+		else {
+			first_pool = i;
+			break;
+		}
+	}
+	if (generators < 1 || generators > MAX_GENERATORS || capacity < 1 || server.max_clients < 1) {
+		fprintf(stderr, "generators must be 1 to %d, pool size and max clients positive\n", MAX_GENERATORS);
+		return 1;
+	}
+
+	for (int i = first_pool; i < argc; ++i) {
+		if (!add_pool(&server, argv[i], capacity)) return 1;
+	}
+	if (server.pool_count == 0) {
+		for (int size = 5; size <= 10; ++size) {
+			char spec[16];
+			snprintf(spec, sizeof(spec), "%d", size);
+			add_pool(&server, spec, capacity);
+		}
+	}
+
+	server.clients = (client_t*)calloc(server.max_clients, sizeof(client_t));
+	server.fds = (struct pollfd*)calloc(server.max_clients + 1, sizeof(struct pollfd));
+	if (!server.clients || !server.fds) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	int listener = open_listener(path);
+	if (listener < 0) return 1;
+	server.fds[0] = (struct pollfd){ listener, POLLIN, 0 };
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = on_signal;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	server.seed = (unsigned)time(NULL) ^ (unsigned)getpid();
+
+	pthread_mutex_init(&server.lock, NULL);
+	pthread_cond_init(&server.space, NULL);
+	pthread_t threads[MAX_GENERATORS];
+	for (int i = 0; i < generators; ++i) {
+		pthread_create(&threads[i], NULL, generator, &server);
+	}
+
+	printf("serving %d pools of %d levels on %s with %d generators\n",
+		server.pool_count, capacity, path, generators);
+	fflush(stdout);
+
+	double start = util_now_ms();
+	while (!stopping) {
+		// Ask for writes only from clients with an answer still queued
+		for (int i = 0; i < server.client_count; ++i) {
+			client_t* client = &server.clients[i];
+			server.fds[i + 1].events = client->out_off < client->out_len ? POLLOUT : POLLIN;
+		}
+
+		int ready = poll(server.fds, server.client_count + 1, 500);
+		if (ready < 0) {
+			if (errno == EINTR) continue;
+			perror("poll");
+			break;
+		}
+
+		// Back to front, dropping a client moves the last one into its place
+		for (int i = server.client_count - 1; i >= 0; --i) {
+			short revents = server.fds[i + 1].revents;
+			if (!revents) continue;
+			if (!serve_client(&server, &server.clients[i], revents)) {
+				drop_client(&server, i);
+			}
+		}
+
+		if (server.fds[0].revents & POLLIN) {
+			accept_clients(&server, listener);
+		}
+	}
+
+	pthread_mutex_lock(&server.lock);
+	server.quit = true;
+	pthread_cond_broadcast(&server.space);
+	pthread_mutex_unlock(&server.lock);
+	for (int i = 0; i < generators; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	double seconds = (util_now_ms() - start) / 1000.0;
+	printf("%lld requests (%lld bad) in %.1f s, %.0f per second\n",
+		server.requests, server.bad_requests, seconds, seconds > 0 ? server.requests / seconds : 0.0);
+	printf("%6s %6s %10s %10s %10s %10s %8s\n", "size", "stars", "generated", "rejected", "served", "empty", "pooled");
+	for (int i = 0; i < server.pool_count; ++i) {
+		pool_t* pool = &server.pools[i];
+		printf("%6d %6d %10lld %10lld %10lld %10lld %8d\n", pool->size, pool->stars,
+			pool->generated, pool->rejected, pool->served, pool->empty, pool->count);
+		free(pool->slots);
+	}
+
+	for (int i = 0; i < server.client_count; ++i) {
+		close(server.clients[i].fd);
+	}
+	close(listener);
+	unlink(path);
+	pthread_cond_destroy(&server.space);
+	pthread_mutex_destroy(&server.lock);
+	free(server.fds);
+	free(server.clients);
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include "grid.h"
+#include "level_io.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THUMB_PADDING 2
+
+/*
+ * Renders every level of a level file into atlas pages with the
+ * software renderer, no window needed. Writes <prefix>_<page>.png and
+ * <prefix>.csv giving the page and rectangle of each level.
+ */
+
+typedef struct {
+	SDL_Surface* surface;
+	SDL_Renderer* renderer;
+	const char* prefix;
+	int thumb;
+	int columns;
+	int rows;
+	int page;
+	int used;
+} atlas_t;
+
+static
+void
+atlas_clear(atlas_t* atlas) {
+	SDL_SetRenderDrawColor(atlas->renderer, 0, 0, 0, 255);
+	SDL_RenderClear(atlas->renderer);
+}
+
+static
+bool
+atlas_save(atlas_t* atlas) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s_%d.png", atlas->prefix, atlas->page);
+
+	SDL_FlushRenderer(atlas->renderer);
+	if (!IMG_SavePNG(atlas->surface, path)) {
+		fprintf(stderr, "cannot write %s: %s\n", path, SDL_GetError());
+		return false;
+	}
+
+	atlas->page++;
+	atlas->used = 0;
+	atlas_clear(atlas);
+	return true;
+}
+
+// Names are free text, quote them and double embedded quotes
+static
+void
+csv_write_field(FILE* file, const char* text) {
+	fputc('"', file);
+	for (; *text; ++text) {
+		if (*text == '"') fputc('"', file);
+		fputc(*text, file);
+	}
+	fputc('"', file);
+}
+
+int
+main(int argc, char* argv[]) {
+	if (argc < 3) {
+		printf("usage: %s <levels|-> <prefix> [thumb_px] [columns] [rows]\n", argv[0]);
+		return 1;
+	}
+
+	atlas_t atlas = { 0 };
+	atlas.prefix = argv[2];
+	atlas.thumb = argc > 3 ? atoi(argv[3]) : 64;
+	atlas.columns = argc > 4 ? atoi(argv[4]) : 32;
+	atlas.rows = argc > 5 ? atoi(argv[5]) : 32;
+	if (atlas.thumb <= 0 || atlas.columns <= 0 || atlas.rows <= 0) {
+		fprintf(stderr, "thumb_px, columns and rows must be positive\n");
+		return 1;
+	}
+
+	level_reader_t* reader = strcmp(argv[1], "-") == 0
+		? level_reader_open_stream(stdin)
+		: level_reader_open(argv[1]);
+	if (!reader) {
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	char index_path[512];
+	snprintf(index_path, sizeof(index_path), "%s.csv", atlas.prefix);
+	FILE* index = fopen(index_path, "w");
+	if (!index) {
+		fprintf(stderr, "cannot open %s\n", index_path);
+		level_reader_close(reader);
+		return 1;
+	}
+	fprintf(index, "level,name,page,x,y,w,h\n");
+
+	if (!SDL_Init(0)) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	int step = atlas.thumb + THUMB_PADDING;
+	int width = atlas.columns * step + THUMB_PADDING;
+	int height = atlas.rows * step + THUMB_PADDING;
+
+	atlas.surface = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+	atlas.renderer = atlas.surface ? SDL_CreateSoftwareRenderer(atlas.surface) : NULL;
+	if (!atlas.renderer) {
+		fprintf(stderr, "Couldn't create software renderer: %s\n", SDL_GetError());
+		return 1;
+	}
+	atlas_clear(&atlas);
+
+	int per_page = atlas.columns * atlas.rows;
+	int count = 0;
+	bool ok = true;
+	Uint64 start = SDL_GetTicks();
+
+	for (;;) {
+		level_meta_t meta;
+		level_t* level = level_reader_next(reader, &meta);
+		if (!level) {
+			const char* error = level_reader_error(reader);
+			if (!error) break;
+			fprintf(stderr, "%s: %s\n", argv[1], error);
+			continue;
+		}
+
+		int slot = atlas.used++;
+		SDL_FRect dst = {
+			(float)(THUMB_PADDING + (slot % atlas.columns) * step),
+			(float)(THUMB_PADDING + (slot / atlas.columns) * step),
+			(float)atlas.thumb,
+			(float)atlas.thumb
+		};
+		level_build_regions(level); // reuses the reader's buffers
+		grid_draw_level(atlas.renderer, level, &dst);
+
+		fprintf(index, "%d,", count);
+		csv_write_field(index, meta.name);
+		fprintf(index, ",%d,%d,%d,%d,%d\n", atlas.page,
+			(int)dst.x, (int)dst.y, atlas.thumb, atlas.thumb);
+		count++;
+
+		if (atlas.used == per_page && !(ok = atlas_save(&atlas))) break;
+	}
+
+	if (ok && atlas.used > 0) {
+		ok = atlas_save(&atlas);
+	}
+
+	printf("%d thumbnails on %d pages in %llu ms\n", count, atlas.page,
+		(unsigned long long)(SDL_GetTicks() - start));
+
+	SDL_DestroyRenderer(atlas.renderer);
+	SDL_DestroySurface(atlas.surface);
+	SDL_Quit();
+
+	fclose(index);
+	level_reader_close(reader);
+	return ok ? 0 : 1;
+}